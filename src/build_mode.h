@@ -0,0 +1,16 @@
+#ifndef COMP6771_ASS2_BUILD_MODE_H
+#define COMP6771_ASS2_BUILD_MODE_H
+
+// By default the library is compiled: the type-erased view is instantiated once in
+// filtered_string_view.cpp and other translation units call into it. Defining FSV_HEADER_ONLY (the
+// FSV_HEADER_ONLY CMake option) makes the headers include the .cpp files of the view and its index
+// instead, with every definition marked FSV_INLINE, so iteration and element access inline into the
+// caller. The SIMD kernels are compiled either way; they are reached through a function pointer
+// chosen at run time, so there is nothing to inline.
+#ifdef FSV_HEADER_ONLY
+#define FSV_INLINE inline
+#else
+#define FSV_INLINE
+#endif
+
+#endif // COMP6771_ASS2_BUILD_MODE_H
@@ -0,0 +1,173 @@
+#ifndef COMP6771_ASS2_CHAR_SET_H
+#define COMP6771_ASS2_CHAR_SET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace fsv {
+	// A set of char values stored as a 256-bit bitmap. It is a predicate in its own right, and
+	// filtered_string_view recognises it behind a `filter` and scans with table lookups instead of calls.
+	class char_set {
+	 public:
+		using word_type = std::uint64_t;
+		static constexpr std::size_t word_count = 4;
+
+		// constructor: the empty set
+		constexpr char_set() noexcept = default;
+
+		// every char value
+		static constexpr auto all() noexcept -> char_set {
+			return ~char_set{};
+		}
+		// the chars in [first, last], compared as unsigned char
+		static constexpr auto range(char first, char last) noexcept -> char_set {
+			auto set = char_set{};
+			for (auto c = static_cast<unsigned>(to_byte(first)); c <= to_byte(last); ++c) {
+				set.set_bit(c);
+			}
+			return set;
+		}
+		// the chars that appear in `chars`
+		static constexpr auto of(std::string_view chars) noexcept -> char_set {
+			auto set = char_set{};
+			for (char c : chars) {
+				set.insert(c);
+			}
+			return set;
+		}
+
+		// <cctype> classes in the "C" locale
+		static constexpr auto digit() noexcept -> char_set {
+			return range('0', '9');
+		}
+		static constexpr auto upper() noexcept -> char_set {
+			return range('A', 'Z');
+		}
+		static constexpr auto lower() noexcept -> char_set {
+			return range('a', 'z');
+		}
+		static constexpr auto alpha() noexcept -> char_set {
+			return upper() | lower();
+		}
+		static constexpr auto alnum() noexcept -> char_set {
+			return alpha() | digit();
+		}
+		static constexpr auto xdigit() noexcept -> char_set {
+			return digit() | range('a', 'f') | range('A', 'F');
+		}
+		static constexpr auto space() noexcept -> char_set {
+			return range('\t', '\r') | of(" ");
+		}
+		static constexpr auto blank() noexcept -> char_set {
+			return of(" \t");
+		}
+		static constexpr auto cntrl() noexcept -> char_set {
+			return range('\0', '\x1f') | of("\x7f");
+		}
+		static constexpr auto print() noexcept -> char_set {
+			return range(' ', '~');
+		}
+		static constexpr auto graph() noexcept -> char_set {
+			return range('!', '~');
+		}
+		static constexpr auto punct() noexcept -> char_set {
+			return graph() - alnum();
+		}
+
+		// modify the set
+		constexpr auto insert(char c) noexcept -> char_set& {
+			set_bit(to_byte(c));
+			return *this;
+		}
+		constexpr auto erase(char c) noexcept -> char_set& {
+			bits_[to_byte(c) / 64] &= ~(word_type{1} << (to_byte(c) % 64));
+			return *this;
+		}
+
+		// branch-free membership test
+		constexpr auto contains(char c) const noexcept -> bool {
+			return ((bits_[to_byte(c) / 64] >> (to_byte(c) % 64)) & 1) != 0;
+		}
+		// use the set as a predicate
+		constexpr auto operator()(const char& c) const noexcept -> bool {
+			return contains(c);
+		}
+
+		// number of char values in the set
+		constexpr auto count() const noexcept -> std::size_t {
+			auto n = std::size_t{0};
+			for (auto word : bits_) {
+				for (; word != 0; word &= word - 1) {
+					++n;
+				}
+			}
+			return n;
+		}
+		// raw bitmap, bit `c % 64` of word `c / 64` for unsigned char c
+		constexpr auto words() const noexcept -> const std::array<word_type, word_count>& {
+			return bits_;
+		}
+
+		// set algebra
+		friend constexpr auto operator~(const char_set& set) noexcept -> char_set {
+			auto result = char_set{};
+			for (std::size_t i = 0; i < word_count; ++i) {
+				result.bits_[i] = ~set.bits_[i];
+			}
+			return result;
+		}
+		friend constexpr auto operator|(const char_set& lhs, const char_set& rhs) noexcept -> char_set {
+			auto result = lhs;
+			for (std::size_t i = 0; i < word_count; ++i) {
+				result.bits_[i] |= rhs.bits_[i];
+			}
+			return result;
+		}
+		friend constexpr auto operator&(const char_set& lhs, const char_set& rhs) noexcept -> char_set {
+			auto result = lhs;
+			for (std::size_t i = 0; i < word_count; ++i) {
+				result.bits_[i] &= rhs.bits_[i];
+			}
+			return result;
+		}
+		friend constexpr auto operator-(const char_set& lhs, const char_set& rhs) noexcept -> char_set {
+			return lhs & ~rhs;
+		}
+		friend constexpr auto operator==(const char_set& lhs, const char_set& rhs) noexcept -> bool = default;
+
+	 private:
+		static constexpr auto to_byte(char c) noexcept -> unsigned char {
+			return static_cast<unsigned char>(c);
+		}
+		constexpr auto set_bit(unsigned c) noexcept -> void {
+			bits_[c / 64] |= word_type{1} << (c % 64);
+		}
+
+		std::array<word_type, word_count> bits_ = {};
+	};
+
+	// Tabulate a predicate that depends only on the char value: it is called once for each of the
+	// 256 values, and views built from the result test bits instead of calling it again.
+	template<typename F>
+	constexpr auto pure(const F& pred) -> char_set {
+		if constexpr (std::is_same_v<F, char_set>) {
+			return pred;
+		}
+		else {
+			auto set = char_set{};
+			for (int i = std::numeric_limits<char>::min(); i <= std::numeric_limits<char>::max(); ++i) {
+				const auto c = static_cast<char>(i);
+				if (pred(c)) {
+					set.insert(c);
+				}
+			}
+			return set;
+		}
+	}
+} // namespace fsv
+
+#endif // COMP6771_ASS2_CHAR_SET_H
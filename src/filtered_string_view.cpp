@@ -1,301 +1,270 @@
 #include "./filtered_string_view.h"
+#include <algorithm>
 #include <compare>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <mutex>
 #include <optional>
+#include <set>
 #include <string>
 #include <utility>
 
 namespace fsv {
-	// class filtered_string_view::iter
-	// Constructor:
-	filtered_string_view::iter::iter(const char* pc, filter pred) noexcept
-	: pc_(pc)
-	, pred_(std::move(pred)) {}
+#ifndef FSV_HEADER_ONLY
+	// the type-erased view
+	template class basic_filtered_string_view<filter>;
+#endif
 
-	auto filtered_string_view::iter::operator*() const noexcept -> reference_type {
-		return *pc_;
-	}
-	auto filtered_string_view::iter::operator->() const noexcept -> pointer_type {}
-	// ++iter
-	auto filtered_string_view::iter::operator++() noexcept -> iter& {
-		pc_++;
-		while (*pc_ != '\0' && !pred_(*pc_)) {
-			pc_++;
-		}
-		return *this;
-	}
-	// iter++
-	auto filtered_string_view::iter::operator++(int) noexcept -> iter {
-		auto new_iter = *this;
-		++(*this);
-		return new_iter;
-	}
-	// --iter
-	auto filtered_string_view::iter::operator--() noexcept -> iter& {
-		pc_--;
-		while (*pc_ != '\0' && !pred_(*pc_)) {
-			pc_--;
-		}
-		return *this;
-	}
-	// iter--
-	auto filtered_string_view::iter::operator--(int) noexcept -> iter {
-		auto new_iter = *this;
-		--(*this);
-		return new_iter;
-	}
-	// == !=
-	auto
-	operator==(const filtered_string_view::iterator& lhs, const filtered_string_view::iterator& rhs) noexcept -> bool {
-		return lhs.pc_ == rhs.pc_;
-	}
-	auto
-	operator!=(const filtered_string_view::iterator& lhs, const filtered_string_view::iterator& rhs) noexcept -> bool {
-		return lhs.pc_ != rhs.pc_;
-	}
+	namespace detail {
+		// every filter of a compose() chain, tested in one loop after the lookup table
+		class conjunction {
+		 public:
+			conjunction(std::optional<char_set> table, std::vector<filter> filts) noexcept
+			: table_(table)
+			, filts_(std::move(filts)) {}
 
-	// class filtered_string_view
-	// iterator of filtered_string_view
-	// begin
-	auto filtered_string_view::begin() const noexcept -> iterator {
-		const char* pc = data_;
-		while (*pc != '\0' && !pred_(*pc)) {
-			pc++;
-		}
-		return {pc, pred_};
-	}
-	auto filtered_string_view::cbegin() const noexcept -> const_iterator {
-		return begin();
-	}
-	// end
-	auto filtered_string_view::end() const noexcept -> iterator {
-		return {data_ + size_, pred_};
-	}
-	auto filtered_string_view::cend() const noexcept -> const_iterator {
-		return end();
-	}
-	// reverse
-	auto filtered_string_view::rbegin() const noexcept -> reverse_iterator {
-		return reverse_iterator(end());
-	}
-	auto filtered_string_view::crbegin() const noexcept -> const_reverse_iterator {
-		return const_reverse_iterator(cend());
-	}
-	auto filtered_string_view::rend() const noexcept -> reverse_iterator {
-		return reverse_iterator(begin());
-	}
-	auto filtered_string_view::crend() const noexcept -> const_reverse_iterator {
-		return reverse_iterator(cbegin());
-	}
-
-	// filtered_string_view
-	filter filtered_string_view::default_predicate = [](const char&) { return true; };
-	// Constructor:
-	// default constructor
-	filtered_string_view::filtered_string_view() noexcept
-	: data_(nullptr)
-	, size_(0)
-	, pred_(default_predicate) {}
-	// String constructor
-	filtered_string_view::filtered_string_view(const std::string& s) noexcept
-	: data_(s.data())
-	, size_(s.size())
-	, pred_(default_predicate) {}
-	// String constructor with Predicate (lack some function should be fixed)
-	filtered_string_view::filtered_string_view(const std::string& s, filter predicate) noexcept
-	: data_(s.data())
-	, size_(s.size())
-	, pred_(std::move(predicate)) {}
-	// Implicit Null-terminated String Constructor
-	filtered_string_view::filtered_string_view(const char* s) noexcept
-	: data_(s)
-	, size_(std::strlen(s))
-	, pred_(default_predicate) {}
-	// Null-Terminated String with Predicate Constructor
-	filtered_string_view::filtered_string_view(const char* s, filter predicate) noexcept
-	: data_(s)
-	, size_(std::strlen(s))
-	, pred_(std::move(predicate)) {}
-	// Copy constructor
-	filtered_string_view::filtered_string_view(const filtered_string_view& other) noexcept = default;
-	// Move constructor
-	filtered_string_view::filtered_string_view(filtered_string_view&& other) noexcept
-	: data_(std::exchange(other.data_, nullptr))
-	, size_(std::exchange(other.size_, 0))
-	, pred_(std::exchange(other.pred_, default_predicate)) {}
-	// =
-	filtered_string_view& filtered_string_view::operator=(const filtered_string_view& other) noexcept {
-		// copy itself
-		if (&other == this) {
-			return *this;
-		}
-		this->data_ = other.data_;
-		this->size_ = other.size_;
-		this->pred_ = other.pred_;
-		return *this;
-	}
-	filtered_string_view& filtered_string_view::operator=(filtered_string_view&& other) noexcept {
-		this->data_ = std::exchange(other.data_, nullptr);
-		this->size_ = std::exchange(other.size_, 0);
-		this->pred_ = std::exchange(other.pred_, default_predicate);
-		return *this;
-	}
-	// []
-	const char& filtered_string_view::operator[](int n) const {
-		int filtered_index = 0;
-		for (size_t i = 0; i < size_; i++) {
-			if (pred_(data_[i])) {
-				if (filtered_index == n) {
-					return data_[i];
+			auto operator()(const char& c) const -> bool {
+				if (table_ && !table_->contains(c)) {
+					return false;
+				}
+				for (const auto& fl : filts_) {
+					if (!fl(c)) {
+						return false;
+					}
 				}
-				filtered_index++;
+				return true;
 			}
-		}
-		return data_[0];
-	}
-
-	// String type conversion
-	filtered_string_view::operator std::string() const {
-		std::string str = {};
-		for (size_t i = 0; i < size_; i++) {
-			if (pred_(data_[i])) {
-				str.push_back(data_[i]);
+			auto table() const noexcept -> const std::optional<char_set>& {
+				return table_;
+			}
+			auto filters() const noexcept -> const std::vector<filter>& {
+				return filts_;
 			}
-		}
-		return str;
-	}
 
-	// get data or size function
-	const char* filtered_string_view::data() const noexcept {
-		return data_;
-	}
-	const filter& filtered_string_view::predicate() const noexcept {
-		return pred_;
-	}
-	const char& filtered_string_view::at(int index) const {
-		if (index < 0) {
-			throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
-		}
-		int n = 0;
-		for (size_t i = 0; i < size_; i++) {
-			if (pred_(data_[i])) {
-				if (n == index) {
-					return data_[i];
+		 private:
+			std::optional<char_set> table_;
+			std::vector<filter> filts_;
+		};
+
+		FSV_INLINE shared_table share_table(const char_set& set) {
+			struct order {
+				auto operator()(const char_set& lhs, const char_set& rhs) const noexcept -> bool {
+					return lhs.words() < rhs.words();
 				}
-				n++;
-			}
+			};
+			// set nodes never move, so the pointers handed out stay valid
+			static auto mutex = std::mutex{};
+			static auto tables = std::set<char_set, order>{};
+			const auto lock = std::scoped_lock{mutex};
+			return shared_table{&*tables.insert(set).first};
 		}
-		throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
-	}
-	std::size_t filtered_string_view::size() const {
-		std::string str = {};
-		for (size_t i = 0; i < size_; i++) {
-			if (pred_(data_[i])) {
-				str.push_back(data_[i]);
+
+		// split pred into the lookup table and opaque callables it is made of
+		FSV_INLINE void flatten(const filter& pred, char_set& table, std::vector<filter>& filts) {
+			if (pred.target<detail::keep_all>() != nullptr) {
+				return;
 			}
-		}
-		return str.size();
-	}
-	// check empty
-	bool filtered_string_view::empty() const noexcept {
-		for (size_t i = 0; i < size_; i++) {
-			if (pred_(data_[i])) {
-				return false;
+			if (const auto* set = as_char_set(pred)) {
+				table = table & *set;
+			}
+			else if (const auto* conj = pred.target<conjunction>()) {
+				if (conj->table()) {
+					table = table & *conj->table();
+				}
+				filts.insert(filts.end(), conj->filters().begin(), conj->filters().end());
+			}
+			else {
+				filts.push_back(pred);
 			}
 		}
-		return true;
-	}
-
-	// None member function
-	filtered_string_view compose(const filtered_string_view& filtered_sv, const std::vector<filter>& filts) noexcept {
-		filter new_pred = filtered_sv.predicate();
-		for (const auto& fl : filts) {
-			filter prev_pred = new_pred;
-			new_pred = [prev_pred, fl](const char& c) { return prev_pred(c) && fl(c); };
-		}
-		return {filtered_sv.data(), new_pred};
-	}
-	std::vector<filtered_string_view> split(const filtered_string_view& fsv, const filtered_string_view& tok) {
-		std::vector<filtered_string_view> result;
-		auto start = fsv.begin();
-		auto end = --fsv.end();
-		auto tok_begin = tok.begin();
-		auto tok_end = tok.end();
-		auto it = fsv.begin();
 
-		while (it != fsv.end()) {
-			auto match = std::search(it, fsv.end(), tok_begin, tok_end);
-			if (match == fsv.end()) {
-				std::string fsv_str = {};
-				for (auto i = start; i != fsv.end(); i++) {
-					fsv_str += *i;
+		// The first match of delim among the kept characters of data[from, size), in one pass. A single
+		// char is found with memchr, kept or not; longer delimiters run Knuth-Morris-Pratt over the kept
+		// characters, jumping with memchr to the next candidate for delim.front() while nothing is
+		// matched, and walk back over the match once to find where it began.
+		template<typename Keep>
+		auto find_match(const char* data, std::size_t size, std::string_view delim,
+		                const std::vector<std::size_t>& borders, std::size_t from, const Keep& keep)
+		   -> std::optional<detail::delimiter_match> {
+			// the next byte equal to c in data[i, size), or size
+			const auto next_byte = [data, size](std::size_t i, char c) -> std::size_t {
+				if (i >= size) {
+					return size;
 				}
-				result.push_back({fsv_str, fsv.predicate()});
-				if (match == end && !result.empty() && std::distance(tok_begin, tok_end) > 0) {
-					result.push_back({"", fsv.predicate()});
+				const auto* hit = static_cast<const char*>(std::memchr(data + i, c, size - i));
+				return hit == nullptr ? size : static_cast<std::size_t>(hit - data);
+			};
+
+			if (delim.size() == 1) {
+				for (auto i = next_byte(from, delim.front()); i < size; i = next_byte(i + 1, delim.front())) {
+					if (keep(data[i])) {
+						return detail::delimiter_match{i, i + 1};
+					}
 				}
-				break;
+				return std::nullopt;
 			}
-			else if (match == end) {
-				std::string fsv_str = {};
-				for (auto i = start; i != end; i++) {
-					fsv_str += *i;
+
+			std::size_t k = 0;
+			for (auto j = from; j < size; j++) {
+				if (k == 0) {
+					j = next_byte(j, delim.front());
+					if (j == size) {
+						break;
+					}
 				}
-				result.push_back({fsv_str, fsv.predicate()});
-				if (match == end && !result.empty() && std::distance(tok_begin, tok_end) > 0) {
-					result.push_back({"", fsv.predicate()});
+				if (!keep(data[j])) {
+					continue;
+				}
+				while (k > 0 && data[j] != delim[k]) {
+					k = borders[k - 1];
+				}
+				if (data[j] == delim[k]) {
+					k++;
+				}
+				if (k == delim.size()) {
+					auto first = j;
+					for (auto kept = std::size_t{1}; kept < delim.size();) {
+						first--;
+						kept += static_cast<std::size_t>(keep(data[first]));
+					}
+					return detail::delimiter_match{first, j + 1};
 				}
-				break;
-			}
-			std::string fsv_str2 = {};
-			for (auto i = start; i != match; i++) {
-				fsv_str2 += *i;
 			}
-			result.push_back({fsv_str2, fsv.predicate()});
-			// update position
-			it = match;
-			start = match;
-			std::advance(it, std::distance(tok_begin, tok_end));
-			std::advance(start, std::distance(tok_begin, tok_end));
+			return std::nullopt;
 		}
+	} // namespace detail
 
+	// None member function
+	FSV_INLINE filtered_string_view
+	compose(const filtered_string_view& filtered_sv, const std::vector<filter>& filts) noexcept {
+		auto table = char_set::all();
+		auto opaque = std::vector<filter>{};
+		detail::flatten(filtered_sv.predicate(), table, opaque);
+		for (const auto& fl : filts) {
+			detail::flatten(fl, table, opaque);
+		}
+
+		// keep the source range: a substr() or split() token ends before the end of its buffer, and a
+		// view of an unterminated buffer has no terminator to stop at
+		if (opaque.empty()) {
+			return {filtered_sv.data(), filtered_sv.source_size(), table};
+		}
+		if (table == char_set::all()) {
+			if (opaque.size() == 1) {
+				return {filtered_sv.data(), filtered_sv.source_size(), opaque.front()};
+			}
+			return {filtered_sv.data(),
+			        filtered_sv.source_size(),
+			        detail::conjunction{std::nullopt, std::move(opaque)}};
+		}
+		return {filtered_sv.data(), filtered_sv.source_size(), detail::conjunction{table, std::move(opaque)}};
+	}
+	FSV_INLINE std::vector<filtered_string_view> split(const filtered_string_view& fsv, const filtered_string_view& tok) {
+		auto result = std::vector<filtered_string_view>{};
+		for (auto token : split_view{fsv, tok}) {
+			result.push_back(std::move(token));
+		}
 		return result;
 	}
-	filtered_string_view substr(const filtered_string_view& fsv, int pos, int count) {
+	FSV_INLINE filtered_string_view substr(const filtered_string_view& fsv, int pos, int count) {
 		int size = static_cast<int>(fsv.size());
 		int rcount = (count <= 0 || count > size - pos) ? size - pos : count;
 		if (pos < 0 || pos >= size) {
 			return {"", fsv.predicate()};
 		}
 
-		auto start_it = fsv.begin();
-		std::advance(start_it, pos);
+		// the source range from the first kept character to the one after the last, found through the
+		// position index; the parent predicate filters the rest, so substr of a substr stays flat
+		const char* first = &fsv[pos];
+		const char* last = pos + rcount < size ? &fsv[pos + rcount] : fsv.data() + fsv.source_size();
+		return {first, static_cast<std::size_t>(last - first), fsv.predicate()};
+	}
 
-		auto end_it = start_it;
-		std::advance(end_it, rcount);
+	namespace detail {
+		FSV_INLINE std::vector<std::size_t> delimiter_borders(std::string_view delim) {
+			auto borders = std::vector<std::size_t>(delim.size(), 0);
+			std::size_t k = 0;
+			for (std::size_t i = 1; i < delim.size(); i++) {
+				while (k > 0 && delim[i] != delim[k]) {
+					k = borders[k - 1];
+				}
+				if (delim[i] == delim[k]) {
+					k++;
+				}
+				borders[i] = k;
+			}
+			return borders;
+		}
+		FSV_INLINE std::optional<delimiter_match> find_delimiter(const filtered_string_view& fsv, std::string_view delim,
+		                                                         const std::vector<std::size_t>& borders, std::size_t from) {
+			if (delim.empty()) {
+				return std::nullopt;
+			}
+			if (const auto* table = as_char_set(fsv.predicate())) {
+				// a delimiter holding a filtered-out char can never match
+				for (char c : delim) {
+					if (!table->contains(c)) {
+						return std::nullopt;
+					}
+				}
+				return find_match(fsv.data(), fsv.source_size(), delim, borders, from, *table);
+			}
+			return find_match(fsv.data(), fsv.source_size(), delim, borders, from, fsv.predicate());
+		}
+	} // namespace detail
 
-		return {fsv.data() + pos, [=](const char& c) { return &c >= &*start_it && &c < &*end_it && fsv.predicate()(c); }};
+	// class split_view
+	FSV_INLINE split_view::split_view(filtered_string_view fsv, const filtered_string_view& tok)
+	: fsv_(std::move(fsv))
+	, delim_(static_cast<std::string>(tok))
+	, borders_(detail::delimiter_borders(delim_))
+	, token_predicate_(fsv_.predicate()) {
+		// a char_set does not fit in std::function's inline buffer, so copying it into every token would
+		// allocate once per token
+		if (token_predicate_.target<char_set>() != nullptr) {
+			token_predicate_ = detail::share_table(*token_predicate_.target<char_set>());
+		}
+	}
+	FSV_INLINE auto split_view::begin() const -> iterator {
+		return {*this, 0};
+	}
+	FSV_INLINE auto split_view::end() const noexcept -> std::default_sentinel_t {
+		return std::default_sentinel;
+	}
+	FSV_INLINE split_view::iterator::iterator(const split_view& parent, std::size_t first)
+	: parent_(&parent)
+	, first_(first)
+	, match_(detail::find_delimiter(parent.fsv_, parent.delim_, parent.borders_, first))
+	, done_(false) {}
+	FSV_INLINE auto split_view::iterator::operator*() const -> value_type {
+		const auto last = match_ ? match_->first : parent_->fsv_.source_size();
+		return {parent_->fsv_.data() + first_, last - first_, parent_->token_predicate_};
+	}
+	FSV_INLINE auto split_view::iterator::operator++() -> iterator& {
+		if (!match_) {
+			done_ = true;
+			return *this;
+		}
+		first_ = match_->last;
+		match_ = detail::find_delimiter(parent_->fsv_, parent_->delim_, parent_->borders_, first_);
+		return *this;
+	}
+	FSV_INLINE auto split_view::iterator::operator++(int) -> iterator {
+		auto old = *this;
+		++*this;
+		return old;
 	}
 
 	// None member operator
 	// == != <==>
-	bool operator==(const filtered_string_view& lhs, const filtered_string_view& rhs) {
-		std::string filtered_str1 = lhs.operator std::string();
-		std::string filtered_str2 = rhs.operator std::string();
-		return filtered_str1 == filtered_str2;
+	FSV_INLINE bool operator==(const filtered_string_view& lhs, const filtered_string_view& rhs) {
+		return lhs.equals(rhs);
 	}
-	bool operator!=(const filtered_string_view& lhs, const filtered_string_view& rhs) {
+	FSV_INLINE bool operator!=(const filtered_string_view& lhs, const filtered_string_view& rhs) {
 		return !(lhs == rhs);
 	}
-	std::strong_ordering operator<=>(const filtered_string_view& lhs, const filtered_string_view& rhs) {
-		std::string filtered_str1 = lhs.operator std::string();
-		std::string filtered_str2 = rhs.operator std::string();
-		return filtered_str1 <=> filtered_str2;
-	}
-	// <<
-	std::ostream& operator<<(std::ostream& os, const filtered_string_view& filtered_sv) noexcept {
-		os << static_cast<std::string>(filtered_sv);
-		return os;
+	FSV_INLINE std::strong_ordering operator<=>(const filtered_string_view& lhs, const filtered_string_view& rhs) {
+		return lhs.compare(rhs);
 	}
 } // namespace fsv
@@ -1,28 +1,110 @@
 #ifndef COMP6771_ASS2_FSV_H
 #define COMP6771_ASS2_FSV_H
 
+#include <algorithm>
+#include <atomic>
 #include <compare>
+#include <concepts>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "./build_mode.h"
+#include "./char_set.h"
+#include "./kernels.h"
+#include "./literal_view.h"
+#include "./position_index.h"
+#include "./search.h"
 
 namespace fsv {
 	using filter = std::function<bool(const char&)>;
-	class filtered_string_view {
+
+	namespace detail {
+		// predicate used when none is given: keeps every character
+		struct keep_all {
+			constexpr auto operator()(const char&) const noexcept -> bool {
+				return true;
+			}
+		};
+
+		// predicate types that can supply a keep-everything default
+		template<typename Pred>
+		concept has_default_predicate = requires {
+			{ Pred::all() } -> std::convertible_to<Pred>;
+		} or std::is_constructible_v<Pred, keep_all>;
+
+		template<has_default_predicate Pred>
+		auto make_default_predicate() -> Pred {
+			if constexpr (requires { Pred::all(); }) {
+				return Pred::all();
+			}
+			else {
+				return Pred(keep_all{});
+			}
+		}
+
+		// A char_set that lives until the program ends, held by pointer. Unlike a char_set it fits in
+		// std::function's inline buffer, so copying a filter that holds one does not allocate.
+		struct shared_table {
+			const char_set* set;
+
+			constexpr auto operator()(const char& c) const noexcept -> bool {
+				return set->contains(c);
+			}
+		};
+		// the one shared copy of set; equal sets share it, so memory grows only with distinct sets
+		auto share_table(const char_set& set) -> shared_table;
+
+		// the lookup table behind a predicate, or nullptr if it is an opaque callable
+		template<typename Pred>
+		auto as_char_set(const Pred& pred) noexcept -> const char_set* {
+			if constexpr (std::is_same_v<Pred, char_set>) {
+				return &pred;
+			}
+			else if constexpr (std::is_same_v<Pred, filter>) {
+				if (const auto* shared = pred.template target<shared_table>()) {
+					return shared->set;
+				}
+				return pred.template target<char_set>();
+			}
+			else {
+				return nullptr;
+			}
+		}
+	} // namespace detail
+
+	// Pred is any callable `bool(const char&)`. Using a concrete lambda or function object lets
+	// the compiler inline it into the scan loops; `filtered_string_view` is the type-erased form.
+	template<typename Pred = filter>
+	class basic_filtered_string_view {
+		// A position in the view plus a pointer back to it for the predicate. It is trivially copyable,
+		// and it is invalidated when the view it came from is moved or destroyed. Stepping by one scans
+		// with the predicate; jumps and distances go through the view's position index.
 		class iter {
-			friend class filtered_string_view;
+			friend class basic_filtered_string_view;
 
 		 public:
-			using iterator_category = std::bidirectional_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
 			using value_type = char;
 			using reference_type = const char&;
 			using pointer_type = void;
 			using difference_type = std::ptrdiff_t;
 			// constructor
-			iter(const char* pc, filter pred) noexcept;
+			iter() noexcept = default;
+			iter(const char* pc, const basic_filtered_string_view& view) noexcept;
 			// get iter pointer
 			auto operator*() const noexcept -> reference_type;
 			auto operator->() const noexcept -> pointer_type;
@@ -31,22 +113,100 @@ namespace fsv {
 			auto operator++(int) noexcept -> iter;
 			auto operator--() noexcept -> iter&;
 			auto operator--(int) noexcept -> iter;
+			// random access
+			auto operator+=(difference_type n) -> iter&;
+			auto operator-=(difference_type n) -> iter&;
+			auto operator[](difference_type n) const -> reference_type;
+			friend auto operator+(iter it, difference_type n) -> iter {
+				return it += n;
+			}
+			friend auto operator+(difference_type n, iter it) -> iter {
+				return it += n;
+			}
+			friend auto operator-(iter it, difference_type n) -> iter {
+				return it -= n;
+			}
+			friend auto operator-(const iter& lhs, const iter& rhs) -> difference_type {
+				return lhs.rank() - rhs.rank();
+			}
 			// compare iter
-			friend auto operator==(const iter& lhs, const iter& rhs) noexcept -> bool;
-			friend auto operator!=(const iter& lhs, const iter& rhs) noexcept -> bool;
+			friend auto operator==(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return lhs.pc_ == rhs.pc_;
+			}
+			friend auto operator!=(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return lhs.pc_ != rhs.pc_;
+			}
+			friend auto operator<=>(const iter& lhs, const iter& rhs) noexcept -> std::strong_ordering {
+				return lhs.pc_ <=> rhs.pc_;
+			}
 
 		 private:
+			// filtered index of this position
+			auto rank() const -> difference_type;
+
 			using pointer = const char*;
-			pointer pc_;
-			filter pred_;
+			pointer pc_ = nullptr;
+			const basic_filtered_string_view* view_ = nullptr;
+		};
+
+		// Forward iterator over the maximal stretches of consecutive kept characters in the source. Like
+		// iter it points back to the view.
+		class run_iter {
+			friend class basic_filtered_string_view;
+
+		 public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			// constructor
+			run_iter() noexcept = default;
+			// the current run
+			auto operator*() const noexcept -> value_type;
+			// find the next run
+			auto operator++() -> run_iter&;
+			auto operator++(int) -> run_iter;
+			// compare run_iter; runs are never empty, so an empty one is the end
+			friend auto operator==(const run_iter& lhs, const run_iter& rhs) noexcept -> bool {
+				return lhs.first_ == rhs.first_ && lhs.last_ == rhs.last_;
+			}
+			friend auto operator==(const run_iter& it, std::default_sentinel_t) noexcept -> bool {
+				return it.first_ == it.last_;
+			}
+
+		 private:
+			run_iter(const basic_filtered_string_view& view, std::size_t from);
+
+			const basic_filtered_string_view* view_ = nullptr;
+			// source offsets of the current run
+			std::size_t first_ = 0;
+			std::size_t last_ = 0;
 		};
 
 	 public:
+		using predicate_type = Pred;
+		// the kept characters as contiguous segments of the source
+		class run_range : public std::ranges::view_interface<run_range> {
+		 public:
+			run_range() noexcept = default;
+			explicit run_range(const basic_filtered_string_view& view) noexcept
+			: view_(&view) {}
+			auto begin() const -> run_iter {
+				return view_ != nullptr ? run_iter{*view_, 0} : run_iter{};
+			}
+			auto end() const noexcept -> std::default_sentinel_t {
+				return std::default_sentinel;
+			}
+
+		 private:
+			const basic_filtered_string_view* view_ = nullptr;
+		};
 		// iterator
 		using const_iterator = iter;
 		using iterator = const_iterator;
 		using reverse_iterator = std::reverse_iterator<iterator>;
 		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+		using run_iterator = run_iter;
 		// begin end
 		auto begin() const noexcept -> iterator;
 		auto cbegin() const noexcept -> const_iterator;
@@ -59,19 +219,27 @@ namespace fsv {
 		auto crend() const noexcept -> const_reverse_iterator;
 
 		// fsv
-		static filter default_predicate;
+		static inline const Pred default_predicate = detail::make_default_predicate<Pred>();
 		// constructor
-		filtered_string_view() noexcept;
-		filtered_string_view(const std::string& s) noexcept;
-		filtered_string_view(const std::string& s, filter predicate) noexcept;
-		filtered_string_view(const char* s) noexcept;
-		filtered_string_view(const char* s, filter predicate) noexcept;
+		basic_filtered_string_view() noexcept;
+		basic_filtered_string_view(const std::string& s) noexcept;
+		basic_filtered_string_view(const std::string& s, Pred predicate) noexcept;
+		basic_filtered_string_view(const char* s) noexcept;
+		basic_filtered_string_view(const char* s, Pred predicate) noexcept;
+		// the count characters at s, which need not be null-terminated
+		basic_filtered_string_view(const char* s, std::size_t count) noexcept;
+		basic_filtered_string_view(const char* s, std::size_t count, Pred predicate) noexcept;
+		// length-delimited buffers, viewed without strlen
+		basic_filtered_string_view(std::string_view s) noexcept;
+		basic_filtered_string_view(std::string_view s, Pred predicate) noexcept;
+		basic_filtered_string_view(std::span<const char> s) noexcept;
+		basic_filtered_string_view(std::span<const char> s, Pred predicate) noexcept;
 		// copy and move
-		filtered_string_view(const filtered_string_view& other) noexcept;
-		filtered_string_view(filtered_string_view&& other) noexcept;
+		basic_filtered_string_view(const basic_filtered_string_view& other) noexcept;
+		basic_filtered_string_view(basic_filtered_string_view&& other) noexcept;
 
-		auto operator=(const filtered_string_view& other) noexcept -> filtered_string_view&;
-		auto operator=(filtered_string_view&& other) noexcept -> filtered_string_view&;
+		auto operator=(const basic_filtered_string_view& other) noexcept -> basic_filtered_string_view&;
+		auto operator=(basic_filtered_string_view&& other) noexcept -> basic_filtered_string_view&;
 		auto operator[](int n) const -> const char&;
 
 		// type conversion by filtered
@@ -79,30 +247,170 @@ namespace fsv {
 
 		// get data originally
 		auto data() const noexcept -> const char*;
+		// number of characters at data() before filtering
+		auto source_size() const noexcept -> std::size_t;
 		// get predicate function
-		auto predicate() const noexcept -> const filter&;
+		auto predicate() const noexcept -> const Pred&;
 		// get a character after filtered
 		auto at(int index) const -> const char&;
 		// get size after filtered
 		auto size() const -> std::size_t;
 		// check empty after filtered
 		auto empty() const noexcept -> bool;
+		// the filtered characters as runs of the source; the range must not outlive the view
+		auto runs() const noexcept -> run_range;
+		// copy up to count filtered characters from filtered position pos to dest, like std::string_view::copy;
+		// returns the number copied and throws std::out_of_range if pos > size()
+		auto copy(char* dest, std::size_t count, std::size_t pos = 0) const -> std::size_t;
+		// Search the filtered characters like std::string_view; positions are filtered indices. Tables
+		// jump between occurrences of the first needle byte with memchr, other predicates stream the
+		// kept characters through Horspool.
+		static constexpr std::size_t npos = std::string_view::npos;
+		auto find(std::string_view needle, std::size_t pos = 0) const -> std::size_t;
+		auto rfind(std::string_view needle, std::size_t pos = npos) const -> std::size_t;
+		auto contains(std::string_view needle) const -> bool;
+		auto starts_with(std::string_view prefix) const -> bool;
+		auto ends_with(std::string_view suffix) const -> bool;
+		// three-way comparison of the filtered characters as unsigned char, stopping at the first difference
+		template<typename P2>
+		auto compare(const basic_filtered_string_view<P2>& other) const -> std::strong_ordering;
+		// whether compare() is equal, answered without reading when both sizes are cached and differ
+		template<typename P2>
+		auto equals(const basic_filtered_string_view<P2>& other) const -> bool;
+
+		// choose how random access is answered; drops any index already built. checkpoint_interval is
+		// the K of index_mode::sparse, and 0 is treated as 1
+		auto set_index_mode(index_mode mode,
+		                    std::size_t checkpoint_interval = detail::default_checkpoint_interval) noexcept -> void;
+		auto get_index_mode() const noexcept -> index_mode;
+		// bytes held by the position index, 0 until it is built
+		auto index_memory_usage() const noexcept -> std::size_t;
+		// forget the cached size and position index, e.g. after the viewed characters were modified
+		auto reset_cache() noexcept -> void;
 
 		// Destructor
-		~filtered_string_view() = default;
+		~basic_filtered_string_view() = default;
 
 	 private:
+		template<typename>
+		friend class basic_filtered_string_view;
+
+		// a moved-from view falls back to the default predicate when Pred allows it
+		auto reset_predicate() noexcept -> void;
+		// call f with the char_set behind pred_ if there is one, otherwise with pred_ itself
+		template<typename F>
+		auto visit_predicate(F&& f) const -> decltype(auto);
+		// the position index, built on first use; nullptr in index_mode::none
+		auto index() const -> const detail::position_index*;
+		// source position of the n-th kept character, or nullptr if there is none
+		auto locate(std::size_t n) const -> const char*;
+		// source offset of the n-th kept character, or size_ if there is none; unlike locate() it uses
+		// the position index only if one is already built
+		auto scan_to(std::size_t n) const -> std::size_t;
+		// number of kept characters before pc; like scan_to() it uses the position index only if one is
+		// already built
+		auto rank_of(const char* pc) const -> std::size_t;
+		// the first kept character at or after pc, or the end of the source; never reads past it
+		auto next_kept(const char* pc) const noexcept -> const char*;
+		// the last kept character before pc, or data_ if there is none; never reads before data_
+		auto prev_kept(const char* pc) const noexcept -> const char*;
+		// whether the kept characters from source offset `offset` on begin with s
+		auto matches_at(std::size_t offset, std::string_view s) const -> bool;
+		// source offsets [first, last) of the first run at or after from, first == size_ if there is none
+		auto next_run(std::size_t from) const -> std::pair<std::size_t, std::size_t>;
+
 		using pointer = const char*;
 		pointer data_;
 		std::size_t size_;
-		filter pred_;
+		Pred pred_;
+		// Caches filled lazily inside const members. They describe data_, size_ and pred_, which only
+		// change together through assignment, so assignment replaces them too; copies share them.
+		// They assume the predicate answers the same way for the life of the view and the viewed
+		// characters do not change (otherwise call reset_cache()). Both are atomic slots, so threads
+		// sharing a const view may race to fill them: racing sizes agree, and the first index published
+		// is the one every thread uses. Only non-const members replace a published index.
+		static constexpr std::size_t unknown_size = ~std::size_t{0};
+		enum index_mode index_mode_ = index_mode::automatic;
+		std::size_t checkpoint_interval_ = detail::default_checkpoint_interval;
+		mutable std::atomic<std::shared_ptr<const detail::position_index>> index_;
+		mutable std::atomic<std::size_t> filtered_size_ = unknown_size;
 	};
 
+	using filtered_string_view = basic_filtered_string_view<filter>;
+
 	// get data after many filtered function
 	auto
 	compose(const filtered_string_view& filtered_sv, const std::vector<filter>& filts) noexcept -> filtered_string_view;
 	// get split data after filtered
 	auto split(const filtered_string_view& fsv, const filtered_string_view& tok) -> std::vector<filtered_string_view>;
+	namespace detail {
+		// source offsets [first, last) of a delimiter and the filtered-out characters inside it
+		struct delimiter_match {
+			std::size_t first;
+			std::size_t last;
+		};
+		// borders[i] is the length of the longest proper prefix of delim[0, i] that is also its suffix
+		auto delimiter_borders(std::string_view delim) -> std::vector<std::size_t>;
+		// the first match of delim among the kept characters of fsv at or after source offset from;
+		// borders is delimiter_borders(delim)
+		auto find_delimiter(const filtered_string_view& fsv, std::string_view delim,
+		                    const std::vector<std::size_t>& borders, std::size_t from) -> std::optional<delimiter_match>;
+	} // namespace detail
+
+	// Lazy split(): the next token is found only when the iterator advances, so stopping after the
+	// first few fields does not tokenize the rest. It yields the same tokens as split(fsv, tok),
+	// including the trailing empty one. Iterators point back to the view and must not outlive it.
+	class split_view : public std::ranges::view_interface<split_view> {
+	 public:
+		class iterator {
+			friend class split_view;
+
+		 public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using value_type = filtered_string_view;
+			using difference_type = std::ptrdiff_t;
+			// constructor
+			iterator() noexcept = default;
+			// the current token
+			auto operator*() const -> value_type;
+			// find the next token
+			auto operator++() -> iterator&;
+			auto operator++(int) -> iterator;
+			// compare iterator
+			friend auto operator==(const iterator& lhs, const iterator& rhs) noexcept -> bool {
+				return lhs.done_ == rhs.done_ && (lhs.done_ || lhs.first_ == rhs.first_);
+			}
+			friend auto operator==(const iterator& it, std::default_sentinel_t) noexcept -> bool {
+				return it.done_;
+			}
+
+		 private:
+			iterator(const split_view& parent, std::size_t first);
+
+			const split_view* parent_ = nullptr;
+			// source offset where the current token begins
+			std::size_t first_ = 0;
+			// the delimiter that ends it, none for the last token
+			std::optional<detail::delimiter_match> match_;
+			bool done_ = true;
+		};
+
+		// constructor
+		split_view() = default;
+		split_view(filtered_string_view fsv, const filtered_string_view& tok);
+		// begin end
+		auto begin() const -> iterator;
+		auto end() const noexcept -> std::default_sentinel_t;
+
+	 private:
+		filtered_string_view fsv_;
+		std::string delim_;
+		std::vector<std::size_t> borders_;
+		// the predicate of every token: fsv_'s, with a table shared rather than copied into each one
+		filter token_predicate_;
+	};
+
 	// get sub-data after filtered
 	auto substr(const filtered_string_view& fsv, int pos = 0, int count = 0) -> filtered_string_view;
 
@@ -110,8 +418,815 @@ namespace fsv {
 	auto operator==(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
 	auto operator!=(const filtered_string_view& lhs, const filtered_string_view& rhs) -> bool;
 	auto operator<=>(const filtered_string_view& lhs, const filtered_string_view& rhs) -> std::strong_ordering;
+	// compare views with different predicate types
+	template<typename P1, typename P2>
+	auto operator==(const basic_filtered_string_view<P1>& lhs, const basic_filtered_string_view<P2>& rhs) -> bool;
+	template<typename P1, typename P2>
+	auto operator<=>(const basic_filtered_string_view<P1>& lhs, const basic_filtered_string_view<P2>& rhs)
+	   -> std::strong_ordering;
 	// output fsv
-	auto operator<<(std::ostream& os, const filtered_string_view& filtered_sv) noexcept -> std::ostream&;
+	template<typename Pred>
+	auto operator<<(std::ostream& os, const basic_filtered_string_view<Pred>& filtered_sv) noexcept -> std::ostream&;
+
+	// class basic_filtered_string_view::iter
+	// Constructor:
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::iter::iter(const char* pc, const basic_filtered_string_view& view) noexcept
+	: pc_(pc)
+	, view_(&view) {}
+
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator*() const noexcept -> reference_type {
+		return *pc_;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator->() const noexcept -> pointer_type {}
+	// ++iter
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator++() noexcept -> iter& {
+		pc_ = view_->next_kept(pc_ + 1);
+		return *this;
+	}
+	// iter++
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator++(int) noexcept -> iter {
+		auto new_iter = *this;
+		++(*this);
+		return new_iter;
+	}
+	// --iter
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator--() noexcept -> iter& {
+		pc_ = view_->prev_kept(pc_);
+		return *this;
+	}
+	// iter--
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator--(int) noexcept -> iter {
+		auto new_iter = *this;
+		--(*this);
+		return new_iter;
+	}
+	// iter += n, past the end clamps to end()
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator+=(difference_type n) -> iter& {
+		const char* pc = view_->locate(static_cast<std::size_t>(rank() + n));
+		pc_ = pc != nullptr ? pc : view_->data_ + view_->size_;
+		return *this;
+	}
+	// iter -= n
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator-=(difference_type n) -> iter& {
+		return *this += -n;
+	}
+	// iter[n]
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::operator[](difference_type n) const -> reference_type {
+		return *(*this + n);
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::iter::rank() const -> difference_type {
+		return static_cast<difference_type>(view_->rank_of(pc_));
+	}
+
+	// class basic_filtered_string_view::run_iter
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::run_iter::run_iter(const basic_filtered_string_view& view, std::size_t from)
+	: view_(&view) {
+		std::tie(first_, last_) = view.next_run(from);
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::run_iter::operator*() const noexcept -> value_type {
+		return {view_->data_ + first_, last_ - first_};
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::run_iter::operator++() -> run_iter& {
+		// the character at last_ is known to be filtered out, so the predicate is not asked again
+		std::tie(first_, last_) = view_->next_run(std::min(last_ + 1, view_->size_));
+		return *this;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::run_iter::operator++(int) -> run_iter {
+		auto old = *this;
+		++*this;
+		return old;
+	}
+
+	// class basic_filtered_string_view
+	// iterator of basic_filtered_string_view
+	// begin
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::begin() const noexcept -> iterator {
+		return {next_kept(data_), *this};
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+	// end
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::end() const noexcept -> iterator {
+		return {data_ + size_, *this};
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::cend() const noexcept -> const_iterator {
+		return end();
+	}
+	// reverse
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::rbegin() const noexcept -> reverse_iterator {
+		return reverse_iterator(end());
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::crbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator(cend());
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::rend() const noexcept -> reverse_iterator {
+		return reverse_iterator(begin());
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::crend() const noexcept -> const_reverse_iterator {
+		return reverse_iterator(cbegin());
+	}
+
+	// Constructor:
+	// default constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view() noexcept
+	: data_(nullptr)
+	, size_(0)
+	, pred_(default_predicate) {}
+	// String constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const std::string& s) noexcept
+	: data_(s.data())
+	, size_(s.size())
+	, pred_(default_predicate) {}
+	// String constructor with Predicate
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const std::string& s, Pred predicate) noexcept
+	: data_(s.data())
+	, size_(s.size())
+	, pred_(std::move(predicate)) {}
+	// Implicit Null-terminated String Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const char* s) noexcept
+	: data_(s)
+	, size_(std::strlen(s))
+	, pred_(default_predicate) {}
+	// Null-Terminated String with Predicate Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const char* s, Pred predicate) noexcept
+	: data_(s)
+	, size_(std::strlen(s))
+	, pred_(std::move(predicate)) {}
+	// Pointer and Length Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const char* s, std::size_t count) noexcept
+	: data_(s)
+	, size_(count)
+	, pred_(default_predicate) {}
+	// Pointer and Length with Predicate Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const char* s, std::size_t count, Pred predicate) noexcept
+	: data_(s)
+	, size_(count)
+	, pred_(std::move(predicate)) {}
+	// String View Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(std::string_view s) noexcept
+	: data_(s.data())
+	, size_(s.size())
+	, pred_(default_predicate) {}
+	// String View with Predicate Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(std::string_view s, Pred predicate) noexcept
+	: data_(s.data())
+	, size_(s.size())
+	, pred_(std::move(predicate)) {}
+	// Span Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(std::span<const char> s) noexcept
+	: data_(s.data())
+	, size_(s.size())
+	, pred_(default_predicate) {}
+	// Span with Predicate Constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(std::span<const char> s, Pred predicate) noexcept
+	: data_(s.data())
+	, size_(s.size())
+	, pred_(std::move(predicate)) {}
+	// Copy constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(const basic_filtered_string_view& other) noexcept
+	: data_(other.data_)
+	, size_(other.size_)
+	, pred_(other.pred_)
+	, index_mode_(other.index_mode_)
+	, checkpoint_interval_(other.checkpoint_interval_)
+	, index_(other.index_.load(std::memory_order_acquire))
+	, filtered_size_(other.filtered_size_.load(std::memory_order_acquire)) {}
+	// Move constructor
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::basic_filtered_string_view(basic_filtered_string_view&& other) noexcept
+	: data_(std::exchange(other.data_, nullptr))
+	, size_(std::exchange(other.size_, 0))
+	, pred_(std::move(other.pred_))
+	, index_mode_(other.index_mode_)
+	, checkpoint_interval_(other.checkpoint_interval_)
+	, index_(other.index_.exchange(nullptr, std::memory_order_acq_rel))
+	, filtered_size_(other.filtered_size_.exchange(unknown_size, std::memory_order_acq_rel)) {
+		other.reset_predicate();
+	}
+	// =
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::operator=(const basic_filtered_string_view& other) noexcept
+	   -> basic_filtered_string_view& {
+		// copy itself
+		if (&other == this) {
+			return *this;
+		}
+		this->data_ = other.data_;
+		this->size_ = other.size_;
+		this->pred_ = other.pred_;
+		this->index_mode_ = other.index_mode_;
+		this->checkpoint_interval_ = other.checkpoint_interval_;
+		this->index_.store(other.index_.load(std::memory_order_acquire), std::memory_order_release);
+		this->filtered_size_.store(other.filtered_size_.load(std::memory_order_acquire), std::memory_order_release);
+		return *this;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::operator=(basic_filtered_string_view&& other) noexcept
+	   -> basic_filtered_string_view& {
+		this->data_ = std::exchange(other.data_, nullptr);
+		this->size_ = std::exchange(other.size_, 0);
+		this->pred_ = std::move(other.pred_);
+		this->index_mode_ = other.index_mode_;
+		this->checkpoint_interval_ = other.checkpoint_interval_;
+		this->index_.store(other.index_.exchange(nullptr, std::memory_order_acq_rel), std::memory_order_release);
+		this->filtered_size_.store(other.filtered_size_.exchange(unknown_size, std::memory_order_acq_rel),
+		                           std::memory_order_release);
+		other.reset_predicate();
+		return *this;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::reset_predicate() noexcept -> void {
+		if constexpr (detail::has_default_predicate<Pred> && std::is_copy_assignable_v<Pred>) {
+			pred_ = default_predicate;
+		}
+	}
+	template<typename Pred>
+	template<typename F>
+	auto basic_filtered_string_view<Pred>::visit_predicate(F&& f) const -> decltype(auto) {
+		if (const auto* table = detail::as_char_set(pred_)) {
+			return std::forward<F>(f)(*table);
+		}
+		return std::forward<F>(f)(pred_);
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::index() const -> const detail::position_index* {
+		auto published = index_.load(std::memory_order_acquire);
+		if (published || index_mode_ == index_mode::none) {
+			return published.get();
+		}
+		auto mode = index_mode_;
+		if (mode == index_mode::automatic) {
+			mode = size_ <= detail::automatic_offsets_limit ? index_mode::offsets : index_mode::rank_select;
+		}
+		auto built = std::shared_ptr<const detail::position_index>{};
+		if (mode == index_mode::offsets) {
+			auto offsets = visit_predicate([this](const auto& keep) {
+				std::vector<std::size_t> offsets;
+				for (size_t i = 0; i < size_; i++) {
+					if (keep(data_[i])) {
+						offsets.push_back(i);
+					}
+				}
+				return offsets;
+			});
+			built = std::make_shared<detail::offset_index>(std::move(offsets), size_);
+		}
+		else if (mode == index_mode::sparse) {
+			auto checkpoints = visit_predicate([this](const auto& keep) {
+				std::vector<std::size_t> checkpoints;
+				checkpoints.reserve(size_ / checkpoint_interval_ + 2);
+				std::size_t n = 0;
+				size_t i = 0;
+				do {
+					checkpoints.push_back(n);
+					for (const auto stop = std::min(i + checkpoint_interval_, size_); i < stop; i++) {
+						n += static_cast<std::size_t>(keep(data_[i]));
+					}
+				} while (i < size_);
+				checkpoints.push_back(n);
+				return checkpoints;
+			});
+			built = std::make_shared<detail::checkpoint_index>(std::move(checkpoints), checkpoint_interval_);
+		}
+		else {
+			auto bits = visit_predicate([this](const auto& keep) {
+				std::vector<detail::rank_select_index::word_type> bits((size_ + 63) / 64);
+				for (size_t i = 0; i < size_; i++) {
+					bits[i / 64] |= detail::rank_select_index::word_type{keep(data_[i])} << (i % 64);
+				}
+				return bits;
+			});
+			built = std::make_shared<detail::rank_select_index>(std::move(bits), size_);
+		}
+		// another thread may have published its index meanwhile; keep whichever came first
+		if (!index_.compare_exchange_strong(published, built, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			return published.get();
+		}
+		return built.get();
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::locate(std::size_t n) const -> const char* {
+		auto from = detail::index_position{0, 0};
+		if (const auto* idx = index()) {
+			from = idx->seek(n);
+			if (idx->exact()) {
+				return from.offset < size_ ? data_ + from.offset : nullptr;
+			}
+		}
+		return visit_predicate([this, n, from](const auto& keep) -> const char* {
+			auto rank = from.rank;
+			for (auto i = from.offset; i < size_; i++) {
+				if (keep(data_[i])) {
+					if (rank == n) {
+						return data_ + i;
+					}
+					rank++;
+				}
+			}
+			return nullptr;
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::scan_to(std::size_t n) const -> std::size_t {
+		auto from = detail::index_position{0, 0};
+		if (const auto idx = index_.load(std::memory_order_acquire)) {
+			from = idx->seek(n);
+			if (idx->exact()) {
+				return std::min(from.offset, size_);
+			}
+		}
+		auto offset = static_cast<std::size_t>(next_kept(data_ + from.offset) - data_);
+		if (n == from.rank) {
+			return offset;
+		}
+		return visit_predicate([this, n, from, offset](const auto& keep) mutable {
+			for (auto rank = from.rank; offset < size_; offset++) {
+				if (keep(data_[offset]) && rank++ == n) {
+					return offset;
+				}
+			}
+			return size_;
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::next_kept(const char* pc) const noexcept -> const char* {
+		const char* last = data_ + size_;
+		return visit_predicate([pc, last](const auto& keep) mutable {
+			// the neighbour is usually kept; tables test a few bytes inline and leave only a long gap to
+			// the SIMD search
+			if constexpr (std::is_same_v<std::decay_t<decltype(keep)>, char_set>) {
+				return pc + detail::find_first_near(keep, pc, static_cast<std::size_t>(last - pc));
+			}
+			else {
+				while (pc != last && !keep(*pc)) {
+					pc++;
+				}
+				return pc;
+			}
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::prev_kept(const char* pc) const noexcept -> const char* {
+		return visit_predicate([this, pc](const auto& keep) mutable {
+			while (pc != data_) {
+				pc--;
+				if (keep(*pc)) {
+					break;
+				}
+			}
+			return pc;
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::next_run(std::size_t from) const -> std::pair<std::size_t, std::size_t> {
+		// table predicates: short runs and gaps end within a few inline lookups, and only longer ones go
+		// to the SIMD search
+		if (const auto* table = detail::as_char_set(pred_)) {
+			const auto first = from + detail::find_first_near(*table, data_ + from, size_ - from);
+			const auto last = first + detail::find_first_near(~*table, data_ + first, size_ - first);
+			return {first, last};
+		}
+		return visit_predicate([this, from](const auto& keep) {
+			auto first = from;
+			while (first < size_ && !keep(data_[first])) {
+				first++;
+			}
+			auto last = std::min(first + 1, size_);
+			while (last < size_ && keep(data_[last])) {
+				last++;
+			}
+			return std::pair{first, last};
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::rank_of(const char* pc) const -> std::size_t {
+		const auto offset = static_cast<std::size_t>(pc - data_);
+		auto from = detail::index_position{0, 0};
+		if (const auto idx = index_.load(std::memory_order_acquire)) {
+			from = idx->seek_offset(offset);
+		}
+		return visit_predicate([this, offset, from](const auto& keep) {
+			auto rank = from.rank;
+			for (auto i = from.offset; i < offset; i++) {
+				if (keep(data_[i])) {
+					rank++;
+				}
+			}
+			return rank;
+		});
+	}
+	// []
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::operator[](int n) const -> const char& {
+		const char* pc = n < 0 ? nullptr : locate(static_cast<std::size_t>(n));
+		return pc != nullptr ? *pc : data_[0];
+	}
+
+	// String type conversion
+	template<typename Pred>
+	basic_filtered_string_view<Pred>::operator std::string() const {
+		// table predicates: size the result exactly, then compact with the SIMD kernel
+		if (const auto* table = detail::as_char_set(pred_)) {
+			auto str = std::string(size(), '\0');
+			detail::compact(*table, data_, size_, str.data(), str.size());
+			return str;
+		}
+		std::string str = {};
+		if (const auto known = filtered_size_.load(std::memory_order_acquire); known != unknown_size) {
+			str.reserve(known);
+		}
+		for (auto run : runs()) {
+			str.append(run);
+		}
+		return str;
+	}
+
+	// get data or size function
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::data() const noexcept -> const char* {
+		return data_;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::source_size() const noexcept -> std::size_t {
+		return size_;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::predicate() const noexcept -> const Pred& {
+		return pred_;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::at(int index) const -> const char& {
+		if (index < 0) {
+			throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+		}
+		const char* pc = locate(static_cast<std::size_t>(index));
+		if (pc != nullptr) {
+			return *pc;
+		}
+		throw std::domain_error{"filtered_string_view::at(" + std::to_string(index) + "): invalid index"};
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::size() const -> std::size_t {
+		if (const auto known = filtered_size_.load(std::memory_order_acquire); known != unknown_size) {
+			return known;
+		}
+		// threads that race here compute the same value, so the last store wins harmlessly
+		std::size_t n = 0;
+		if (const auto idx = index_.load(std::memory_order_acquire)) {
+			n = idx->size();
+		}
+		else if (const auto* table = detail::as_char_set(pred_)) {
+			n = detail::count(*table, data_, size_);
+		}
+		else {
+			n = visit_predicate([this](const auto& keep) {
+				std::size_t kept = 0;
+				for (size_t i = 0; i < size_; i++) {
+					kept += static_cast<std::size_t>(keep(data_[i]));
+				}
+				return kept;
+			});
+		}
+		filtered_size_.store(n, std::memory_order_release);
+		return n;
+	}
+	// check empty
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::empty() const noexcept -> bool {
+		if (const auto known = filtered_size_.load(std::memory_order_acquire); known != unknown_size) {
+			return known == 0;
+		}
+		if (const auto* table = detail::as_char_set(pred_)) {
+			return detail::find_first(*table, data_, size_) == size_;
+		}
+		return visit_predicate([this](const auto& keep) {
+			for (size_t i = 0; i < size_; i++) {
+				if (keep(data_[i])) {
+					return false;
+				}
+			}
+			return true;
+		});
+	}
+
+	// compare
+	template<typename Pred>
+	template<typename P2>
+	auto basic_filtered_string_view<Pred>::compare(const basic_filtered_string_view<P2>& other) const
+	   -> std::strong_ordering {
+		const auto* ltable = detail::as_char_set(pred_);
+		const auto* rtable = detail::as_char_set(other.pred_);
+		if (ltable != nullptr && rtable != nullptr) {
+			if (data_ == other.data_ && size_ == other.size_ && *ltable == *rtable) {
+				return std::strong_ordering::equal;
+			}
+			return detail::compare(*ltable, data_, size_, *rtable, other.data_, other.size_) <=> 0;
+		}
+		// walk both filtered streams in lockstep
+		return visit_predicate([this, &other](const auto& lkeep) {
+			return other.visit_predicate([this, &other, &lkeep](const auto& rkeep) {
+				std::size_t i = 0;
+				std::size_t j = 0;
+				while (true) {
+					while (i < size_ && !lkeep(data_[i])) {
+						i++;
+					}
+					while (j < other.size_ && !rkeep(other.data_[j])) {
+						j++;
+					}
+					if (i == size_ || j == other.size_) {
+						return (j == other.size_) <=> (i == size_);
+					}
+					if (data_[i] != other.data_[j]) {
+						return static_cast<unsigned char>(data_[i]) <=> static_cast<unsigned char>(other.data_[j]);
+					}
+					i++;
+					j++;
+				}
+			});
+		});
+	}
+	template<typename Pred>
+	template<typename P2>
+	auto basic_filtered_string_view<Pred>::equals(const basic_filtered_string_view<P2>& other) const -> bool {
+		const auto lsize = filtered_size_.load(std::memory_order_acquire);
+		const auto rsize = other.filtered_size_.load(std::memory_order_acquire);
+		if (lsize != unknown_size && rsize != unknown_size && lsize != rsize) {
+			return false;
+		}
+		return std::is_eq(compare(other));
+	}
+
+	// search
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::find(std::string_view needle, std::size_t pos) const -> std::size_t {
+		// a search reads the source once, so building the position index to find pos would cost more
+		// than the search
+		auto offset = scan_to(pos);
+		if (offset == size_) {
+			// only the empty needle matches at the end
+			return needle.empty() && pos == size() ? pos : npos;
+		}
+		if (needle.empty()) {
+			return pos;
+		}
+		if (const auto* table = detail::as_char_set(pred_)) {
+			if (!table->contains(needle.front())) {
+				return npos;
+			}
+			// count the kept characters skipped by each jump to keep track of the filtered index; short
+			// gaps are counted inline
+			auto rank = pos;
+			while (offset < size_) {
+				const void* hit = std::memchr(data_ + offset, needle.front(), size_ - offset);
+				if (hit == nullptr) {
+					break;
+				}
+				const auto at = static_cast<std::size_t>(static_cast<const char*>(hit) - data_);
+				if (at - offset < detail::scalar_cutoff) {
+					for (; offset < at; offset++) {
+						rank += static_cast<std::size_t>(table->contains(data_[offset]));
+					}
+				}
+				else {
+					rank += detail::count(*table, data_ + offset, at - offset);
+				}
+				if (matches_at(at, needle)) {
+					return rank;
+				}
+				offset = at + 1;
+				rank++;
+			}
+			return npos;
+		}
+		return visit_predicate([this, needle, pos, offset](const auto& keep) mutable -> std::size_t {
+			const auto found = detail::horspool{needle}.search([this, &keep, &offset]() -> std::optional<char> {
+				while (offset < size_ && !keep(data_[offset])) {
+					offset++;
+				}
+				if (offset == size_) {
+					return std::nullopt;
+				}
+				return data_[offset++];
+			});
+			return found ? pos + *found : npos;
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::rfind(std::string_view needle, std::size_t pos) const -> std::size_t {
+		const auto n = size();
+		if (needle.size() > n) {
+			return npos;
+		}
+		const auto last_start = std::min(pos, n - needle.size());
+		if (needle.empty()) {
+			return last_start;
+		}
+		// stream the kept characters backwards from the end of the last allowed match, looking for the
+		// reversed needle
+		const auto stop = last_start + needle.size();
+		auto offset = scan_to(stop);
+		const auto reversed = std::string(needle.rbegin(), needle.rend());
+		return visit_predicate([this, &reversed, stop, offset](const auto& keep) mutable -> std::size_t {
+			const auto found = detail::horspool{reversed}.search([this, &keep, &offset]() -> std::optional<char> {
+				while (offset > 0) {
+					offset--;
+					if (keep(data_[offset])) {
+						return data_[offset];
+					}
+				}
+				return std::nullopt;
+			});
+			return found ? stop - reversed.size() - *found : npos;
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::contains(std::string_view needle) const -> bool {
+		return find(needle) != npos;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::starts_with(std::string_view prefix) const -> bool {
+		return matches_at(0, prefix);
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::ends_with(std::string_view suffix) const -> bool {
+		return visit_predicate([this, suffix](const auto& keep) {
+			auto k = suffix.size();
+			for (auto i = size_; i > 0 && k > 0; i--) {
+				if (keep(data_[i - 1])) {
+					if (data_[i - 1] != suffix[k - 1]) {
+						return false;
+					}
+					k--;
+				}
+			}
+			return k == 0;
+		});
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::matches_at(std::size_t offset, std::string_view s) const -> bool {
+		return visit_predicate([this, offset, s](const auto& keep) {
+			std::size_t k = 0;
+			for (auto i = offset; i < size_ && k < s.size(); i++) {
+				if (keep(data_[i])) {
+					if (data_[i] != s[k]) {
+						return false;
+					}
+					k++;
+				}
+			}
+			return k == s.size();
+		});
+	}
+
+	// runs
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::runs() const noexcept -> run_range {
+		return run_range{*this};
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::copy(char* dest, std::size_t count, std::size_t pos) const -> std::size_t {
+		const auto start = pos;
+		std::size_t copied = 0;
+		for (auto run : runs()) {
+			// pos is checked against size() even when nothing is to be copied
+			if (copied == count && pos == 0) {
+				break;
+			}
+			if (pos >= run.size()) {
+				pos -= run.size();
+				continue;
+			}
+			run.remove_prefix(pos);
+			pos = 0;
+			const auto n = std::min(run.size(), count - copied);
+			std::memcpy(dest + copied, run.data(), n);
+			copied += n;
+		}
+		if (pos > 0) {
+			throw std::out_of_range{"filtered_string_view::copy(" + std::to_string(start) + "): invalid position"};
+		}
+		return copied;
+	}
+
+	// random access index
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::set_index_mode(index_mode mode, std::size_t checkpoint_interval) noexcept
+	   -> void {
+		index_mode_ = mode;
+		checkpoint_interval_ = std::max<std::size_t>(checkpoint_interval, 1);
+		index_.store(nullptr, std::memory_order_release);
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::get_index_mode() const noexcept -> index_mode {
+		return index_mode_;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::index_memory_usage() const noexcept -> std::size_t {
+		const auto idx = index_.load(std::memory_order_acquire);
+		return idx ? idx->memory_usage() : 0;
+	}
+	template<typename Pred>
+	auto basic_filtered_string_view<Pred>::reset_cache() noexcept -> void {
+		index_.store(nullptr, std::memory_order_release);
+		filtered_size_.store(unknown_size, std::memory_order_release);
+	}
+
+	// None member operator
+	// == <=> for views with any predicate types
+	template<typename P1, typename P2>
+	auto operator==(const basic_filtered_string_view<P1>& lhs, const basic_filtered_string_view<P2>& rhs) -> bool {
+		return lhs.equals(rhs);
+	}
+	template<typename P1, typename P2>
+	auto operator<=>(const basic_filtered_string_view<P1>& lhs, const basic_filtered_string_view<P2>& rhs)
+	   -> std::strong_ordering {
+		return lhs.compare(rhs);
+	}
+	// <<
+	template<typename Pred>
+	auto operator<<(std::ostream& os, const basic_filtered_string_view<Pred>& filtered_sv) noexcept -> std::ostream& {
+		// runs are written straight to the stream; a field width pads as it would for a std::string
+		const auto width = os.width();
+		const auto fill = width > 0 ? width - static_cast<std::streamsize>(filtered_sv.size()) : 0;
+		const bool left = (os.flags() & std::ios_base::adjustfield) == std::ios_base::left;
+		const auto pad = [&os](std::streamsize n) {
+			for (; n > 0; --n) {
+				os.put(os.fill());
+			}
+		};
+		os.width(0);
+		if (!left) {
+			pad(fill);
+		}
+		for (auto run : filtered_sv.runs()) {
+			os.write(run.data(), static_cast<std::streamsize>(run.size()));
+		}
+		if (left) {
+			pad(fill);
+		}
+		return os;
+	}
+
+#ifndef FSV_HEADER_ONLY
+	// the type-erased view is compiled once in filtered_string_view.cpp
+	extern template class basic_filtered_string_view<filter>;
+#endif
 } // namespace fsv
 
+// hash of the filtered characters, so views that compare equal hash equal whatever their source
+template<typename Pred>
+struct std::hash<fsv::basic_filtered_string_view<Pred>> {
+	auto operator()(const fsv::basic_filtered_string_view<Pred>& view) const -> std::size_t {
+		// 64-bit FNV-1a, fed run by run
+		auto h = std::uint64_t{14695981039346656037u};
+		for (auto run : view.runs()) {
+			for (char c : run) {
+				h = (h ^ static_cast<unsigned char>(c)) * 1099511628211u;
+			}
+		}
+		return static_cast<std::size_t>(h);
+	}
+};
+
+#ifdef FSV_HEADER_ONLY
+#include "./filtered_string_view.cpp"
+#endif
+
 #endif // COMP6771_ASS2_FSV_H
@@ -1,11 +1,41 @@
 #include "./filtered_string_view.h"
+#include <algorithm>
+#include <atomic>
 #include <catch2/catch.hpp>
+#include <cstdlib>
+#include <iomanip>
 #include <iterator>
 #include <limits>
+#include <new>
 #include <set>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <vector>
 
+namespace {
+	// calls to the global operator new below, for tests that count allocations
+	std::atomic<std::size_t> allocations = 0;
+} // namespace
+
+// inlined at -O2, GCC flags free() on memory from operator new, which is the point of replacing both
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+auto operator new(std::size_t size) -> void* {
+	++allocations;
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+auto operator delete(void* p) noexcept -> void {
+	std::free(p);
+}
+auto operator delete(void* p, std::size_t) noexcept -> void {
+	std::free(p);
+}
+#pragma GCC diagnostic pop
+
 TEST_CASE("Test default_predicate for all char values") {
 	for (char c = std::numeric_limits<char>::min(); c != std::numeric_limits<char>::max(); ++c) {
 		REQUIRE(fsv::filtered_string_view::default_predicate(c));
@@ -272,3 +302,847 @@ TEST_CASE("Test substr function with isupper predicate") {
 	auto sv1 = fsv::filtered_string_view{"Sled Dog", is_upper};
 	REQUIRE(fsv::substr(sv1, 0, 2) == "SD");
 }
+
+TEST_CASE("Test basic_filtered_string_view with lambda predicate type") {
+	auto is_digit = [](const char& c) { return c >= '0' && c <= '9'; };
+	auto s = std::string{"a1b2c3"};
+	auto sv = fsv::basic_filtered_string_view{s, is_digit};
+	static_assert(std::is_same_v<decltype(sv)::predicate_type, decltype(is_digit)>);
+	REQUIRE(sv.size() == 3);
+	REQUIRE(sv.at(1) == '2');
+	REQUIRE(static_cast<std::string>(sv) == "123");
+	REQUIRE(std::string(sv.begin(), sv.end()) == "123");
+	REQUIRE(std::string(sv.rbegin(), sv.rend()) == "321");
+}
+
+TEST_CASE("Test basic_filtered_string_view with function object predicate type") {
+	struct not_space {
+		auto operator()(const char& c) const -> bool {
+			return c != ' ';
+		}
+	};
+	auto sv = fsv::basic_filtered_string_view<not_space>{"a b c", not_space{}};
+	auto moved = std::move(sv);
+	REQUIRE(moved == fsv::filtered_string_view{"abc"});
+	REQUIRE(sv.empty());
+}
+
+TEST_CASE("Test char_set classes at compile time") {
+	constexpr auto not_space = ~fsv::char_set::space();
+	static_assert(not_space('a') && !not_space(' ') && !not_space('\n'));
+	static_assert(fsv::char_set::alnum().count() == 62);
+	static_assert(fsv::char_set::punct().contains('!') && !fsv::char_set::punct().contains('a'));
+	static_assert((fsv::char_set::range('a', 'c') | fsv::char_set::of("xyz")) == fsv::char_set::of("abcxyz"));
+	static_assert(fsv::char_set::all().contains('\xff') && fsv::char_set::all().count() == 256);
+}
+
+TEST_CASE("Test char_set predicate through filter") {
+	auto s = std::string{"a1 b2\tc3\n"};
+	auto sv = fsv::filtered_string_view{s, ~fsv::char_set::space()};
+	REQUIRE(sv.predicate().target<fsv::char_set>() != nullptr);
+	REQUIRE(sv.size() == 6);
+	REQUIRE(sv.at(3) == '2');
+	REQUIRE(sv[5] == '3');
+	REQUIRE(static_cast<std::string>(sv) == "a1b2c3");
+	REQUIRE(std::string(sv.rbegin(), sv.rend()) == "3c2b1a");
+	REQUIRE(fsv::filtered_string_view{s, fsv::char_set::upper()}.empty());
+}
+
+TEST_CASE("Test char_set as predicate type") {
+	auto sv = fsv::basic_filtered_string_view{"Hello, World!", fsv::char_set::alpha()};
+	REQUIRE(sv == fsv::filtered_string_view{"HelloWorld"});
+	auto all = fsv::basic_filtered_string_view<fsv::char_set>{"a b"};
+	REQUIRE(all.size() == 3);
+}
+
+TEST_CASE("Test compose collapses char_set filters into one table") {
+	auto sv = fsv::filtered_string_view{"Hello, World 42!", fsv::char_set::alnum()};
+	auto vf = std::vector<fsv::filter>{fsv::char_set::alpha(), ~fsv::char_set::upper()};
+	auto composed = fsv::compose(sv, vf);
+	const auto* table = composed.predicate().target<fsv::char_set>();
+	REQUIRE(table != nullptr);
+	REQUIRE(*table == fsv::char_set::lower());
+	REQUIRE(composed == "elloorld");
+}
+
+TEST_CASE("Test compose of a composed view stays flat") {
+	auto calls = 0;
+	auto not_l = [&calls](const char& c) {
+		++calls;
+		return c != 'l';
+	};
+	auto sv = fsv::filtered_string_view{"Hello, World"};
+	auto once = fsv::compose(sv, {fsv::char_set::alpha(), not_l});
+	auto twice = fsv::compose(once, {[](const char& c) { return c != 'o'; }, ~fsv::char_set::upper()});
+	REQUIRE(static_cast<std::string>(twice) == "erd");
+	REQUIRE(calls == 8);
+}
+
+TEST_CASE("Test pure tabulates a predicate once") {
+	auto calls = 0;
+	auto is_vowel = [&calls](const char& c) {
+		++calls;
+		return std::string_view{"aeiou"}.find(c) != std::string_view::npos;
+	};
+	auto sv = fsv::filtered_string_view{"Malamute", fsv::pure(is_vowel)};
+	REQUIRE(calls == 256);
+	REQUIRE(sv.size() == 4);
+	REQUIRE(sv.at(2) == 'u');
+	REQUIRE(calls == 256);
+	static_assert(fsv::pure([](const char& c) { return c == 'x'; }) == fsv::char_set::of("x"));
+}
+
+TEST_CASE("Test pure with compose and substr") {
+	auto calls = 0;
+	auto not_a = [&calls](const char& c) {
+		++calls;
+		return c != 'a';
+	};
+	auto sv = fsv::filtered_string_view{"banana split"};
+	auto composed = fsv::compose(sv, {fsv::char_set::alpha(), not_a});
+	auto memo = fsv::filtered_string_view{sv.data(), fsv::pure(composed.predicate())};
+	calls = 0;
+	REQUIRE(memo == "bnnsplit");
+	REQUIRE(fsv::substr(memo, 3, 4) == "spli");
+	REQUIRE(calls == 0);
+}
+
+TEST_CASE("Test iterator is a trivially copyable handle") {
+	using iterator = fsv::filtered_string_view::iterator;
+	static_assert(std::is_trivially_copyable_v<iterator>);
+	static_assert(sizeof(iterator) <= 16);
+	static_assert(std::bidirectional_iterator<iterator>);
+
+	auto sv = fsv::filtered_string_view{"a-b-c", [](const char& c) { return c != '-'; }};
+	auto it = sv.begin();
+	auto copy = it++;
+	REQUIRE(*copy == 'a');
+	REQUIRE(*it == 'b');
+	REQUIRE(std::distance(sv.begin(), sv.end()) == 3);
+}
+
+TEST_CASE("Test at reuses the position index") {
+	auto calls = 0;
+	auto not_dash = [&calls](const char& c) {
+		++calls;
+		return c != '-';
+	};
+	auto s = std::string{"a-b--c---d"};
+	auto sv = fsv::filtered_string_view{s, not_dash};
+	REQUIRE(sv.at(3) == 'd');
+	const auto built = calls;
+	for (int i = 0; i < 4; ++i) {
+		REQUIRE(sv.at(i) == "abcd"[i]);
+		REQUIRE(sv[i] == "abcd"[i]);
+	}
+	REQUIRE_THROWS_AS(sv.at(4), std::domain_error);
+	REQUIRE(calls == built);
+}
+
+TEST_CASE("Test random access iterator") {
+	static_assert(std::random_access_iterator<fsv::filtered_string_view::iterator>);
+	auto sv = fsv::filtered_string_view{"0x1x2x3x4", [](const char& c) { return c != 'x'; }};
+	auto first = sv.begin();
+	REQUIRE(*(first + 3) == '3');
+	REQUIRE(first[4] == '4');
+	REQUIRE(sv.end() - first == 5);
+	REQUIRE(*(sv.end() - 2) == '3');
+	REQUIRE(first + 5 == sv.end());
+	REQUIRE(first < first + 1);
+	REQUIRE(std::string(sv.rbegin() + 1, sv.rend() - 1) == "321");
+}
+
+TEST_CASE("Test index_mode none scans without an index") {
+	auto sv = fsv::filtered_string_view{"a b c", fsv::char_set::alpha()};
+	sv.set_index_mode(fsv::index_mode::none);
+	REQUIRE(sv.get_index_mode() == fsv::index_mode::none);
+	REQUIRE(sv.at(2) == 'c');
+	REQUIRE(sv.end() - sv.begin() == 3);
+	auto copy = sv;
+	REQUIRE(copy.get_index_mode() == fsv::index_mode::none);
+}
+
+TEST_CASE("Test size is counted once and cached") {
+	auto calls = 0;
+	auto is_digit = [&calls](const char& c) {
+		++calls;
+		return c >= '0' && c <= '9';
+	};
+	auto s = std::string{"a1b22c333"};
+	auto sv = fsv::filtered_string_view{s, is_digit};
+	REQUIRE(sv.size() == 6);
+	REQUIRE(calls == 9);
+	REQUIRE(sv.size() == 6);
+	REQUIRE_FALSE(sv.empty());
+	REQUIRE(calls == 9);
+
+	auto copy = sv;
+	REQUIRE(copy.size() == 6);
+	REQUIRE(calls == 9);
+
+	s[0] = '9';
+	sv.reset_cache();
+	REQUIRE(sv.size() == 7);
+	REQUIRE(sv.at(0) == '9');
+}
+
+TEST_CASE("Test cached size follows assignment") {
+	auto sv = fsv::filtered_string_view{"abc"};
+	REQUIRE(sv.size() == 3);
+	sv = fsv::filtered_string_view{"de"};
+	REQUIRE(sv.size() == 2);
+	auto moved = std::move(sv);
+	REQUIRE(moved.size() == 2);
+	REQUIRE(sv.size() == 0);
+	REQUIRE(sv.empty());
+}
+
+TEST_CASE("Test threads sharing a const view agree on its size") {
+	auto s = std::string(100000, 'a');
+	for (auto i = std::size_t{0}; i < s.size(); i += 3) {
+		s[i] = '-';
+	}
+	const auto lambda_view = fsv::filtered_string_view{s, [](const char& c) { return c != '-'; }};
+	const auto table_view = fsv::filtered_string_view{s, fsv::char_set::of("a")};
+	const auto expected = s.size() - (s.size() + 2) / 3;
+
+	auto results = std::vector<std::size_t>(8);
+	auto threads = std::vector<std::thread>{};
+	for (auto t = std::size_t{0}; t < results.size(); t++) {
+		threads.emplace_back([&, t] {
+			const auto& sv = t % 2 == 0 ? lambda_view : table_view;
+			auto copy = sv;
+			results[t] = sv.size() + (sv.empty() ? 1 : 0) + (copy.size() == sv.size() ? 0 : 1);
+		});
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	for (auto n : results) {
+		REQUIRE(n == expected);
+	}
+}
+
+TEST_CASE("Test threads sharing a const view publish one position index") {
+	auto s = std::string{};
+	for (int i = 0; i < 5000; ++i) {
+		s += (i % 5 == 0) ? "ab" : "-";
+	}
+	const auto expected = static_cast<std::string>(fsv::filtered_string_view{s, ~fsv::char_set::of("-")});
+	for (auto mode : {fsv::index_mode::offsets, fsv::index_mode::rank_select, fsv::index_mode::sparse}) {
+		auto sv = fsv::filtered_string_view{s, [](const char& c) { return c != '-'; }};
+		sv.set_index_mode(mode, 16);
+		const auto& shared = sv;
+
+		auto mismatches = std::vector<int>(8);
+		auto threads = std::vector<std::thread>{};
+		for (auto t = std::size_t{0}; t < mismatches.size(); t++) {
+			threads.emplace_back([&, t] {
+				for (auto n = t; n < expected.size(); n += 37) {
+					mismatches[t] += shared.at(static_cast<int>(n)) != expected[n] ? 1 : 0;
+					mismatches[t] += shared.begin() + static_cast<std::ptrdiff_t>(n) - shared.begin()
+					                       != static_cast<std::ptrdiff_t>(n)
+					                    ? 1
+					                    : 0;
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		REQUIRE(std::count(mismatches.begin(), mismatches.end(), 0) == 8);
+		REQUIRE(shared.index_memory_usage() > 0);
+	}
+}
+
+TEST_CASE("Test iterator distance leaves the position index alone") {
+	auto s = std::string{};
+	for (int i = 0; i < 3000; ++i) {
+		s += "ab-c"[i % 4];
+	}
+	const auto table = fsv::filtered_string_view{s, ~fsv::char_set::of("-")};
+	const auto opaque = fsv::filtered_string_view{s, [](const char& c) { return c != '-'; }};
+	const auto expected = static_cast<std::string>(table);
+	for (const auto* sv : {&table, &opaque}) {
+		REQUIRE(std::distance(sv->begin(), sv->end()) == static_cast<std::ptrdiff_t>(expected.size()));
+		REQUIRE(std::string(sv->begin(), sv->end()) == expected);
+		auto it = sv->end();
+		--it;
+		--it;
+		REQUIRE(sv->end() - it == 2);
+		REQUIRE(it - sv->begin() == static_cast<std::ptrdiff_t>(expected.size()) - 2);
+		REQUIRE(sv->index_memory_usage() == 0);
+	}
+}
+
+TEST_CASE("Test rank_select index matches a linear scan") {
+	auto s = std::string(100000, ' ');
+	auto seed = 12345u;
+	for (auto& c : s) {
+		seed = seed * 1103515245u + 12345u;
+		c = static_cast<char>('a' + (seed >> 16) % 26);
+	}
+	// one sparse and one dense selectivity
+	for (auto set : {fsv::char_set::of("q"), ~fsv::char_set::of("e")}) {
+		auto expected = std::string{};
+		std::copy_if(s.begin(), s.end(), std::back_inserter(expected), set);
+		auto sv = fsv::filtered_string_view{s, set};
+		sv.set_index_mode(fsv::index_mode::rank_select);
+		REQUIRE(sv.size() == expected.size());
+		for (std::size_t i = 0; i < expected.size(); i += 97) {
+			REQUIRE(sv.at(static_cast<int>(i)) == expected[i]);
+		}
+		REQUIRE(sv.at(static_cast<int>(expected.size() - 1)) == expected.back());
+		REQUIRE_THROWS_AS(sv.at(static_cast<int>(expected.size())), std::domain_error);
+		REQUIRE(sv.end() - sv.begin() == static_cast<std::ptrdiff_t>(expected.size()));
+		const auto mid = static_cast<std::ptrdiff_t>(expected.size() / 2);
+		REQUIRE(*(sv.begin() + mid) == expected[expected.size() / 2]);
+		REQUIRE(*(sv.end() - 1) == expected.back());
+	}
+}
+
+TEST_CASE("Test sparse checkpoint index") {
+	auto s = std::string{};
+	for (int i = 0; i < 2000; ++i) {
+		s += (i % 7 == 0) ? "keep" : "----";
+	}
+	auto sv = fsv::filtered_string_view{s, [](const char& c) { return c != '-'; }};
+	sv.set_index_mode(fsv::index_mode::sparse, 64);
+	REQUIRE(sv.index_memory_usage() == 0);
+	REQUIRE(sv.size() == 286 * 4);
+	REQUIRE(sv.at(0) == 'k');
+	REQUIRE(sv.at(5) == 'e');
+	REQUIRE(sv.at(1143) == 'p');
+	REQUIRE_THROWS_AS(sv.at(1144), std::domain_error);
+	REQUIRE(sv.end() - sv.begin() == 1144);
+	REQUIRE(*(sv.begin() + 1000) == "keep"[1000 % 4]);
+	REQUIRE(sv.index_memory_usage() <= (s.size() / 64 + 2) * sizeof(std::size_t));
+
+	sv.set_index_mode(fsv::index_mode::sparse, 0);
+	REQUIRE(sv.at(7) == 'p');
+}
+
+TEST_CASE("Test string conversion with char_set matches a per-character copy") {
+	auto s = std::string{};
+	for (int i = 0; i < 1000; ++i) {
+		s += static_cast<char>((i * 7919) % 256);
+	}
+	for (auto set : {fsv::char_set{}, fsv::char_set::all(), fsv::char_set::alnum(), ~fsv::char_set::cntrl(),
+	                 fsv::char_set::range('\x80', '\xff') | fsv::char_set::of("az")})
+	{
+		for (std::size_t len : {0u, 1u, 15u, 16u, 17u, 31u, 32u, 33u, 100u, 1000u}) {
+			auto source = s.substr(0, len);
+			auto expected = std::string{};
+			std::copy_if(source.begin(), source.end(), std::back_inserter(expected), set);
+			REQUIRE(static_cast<std::string>(fsv::filtered_string_view{source, set}) == expected);
+		}
+	}
+}
+
+TEST_CASE("Test size and empty with char_set on long inputs") {
+	auto s = std::string(1000, ' ');
+	for (std::size_t pos : {0u, 1u, 63u, 64u, 65u, 500u, 999u}) {
+		auto line = s;
+		line[pos] = 'x';
+		auto sv = fsv::filtered_string_view{line, ~fsv::char_set::space()};
+		REQUIRE_FALSE(sv.empty());
+		REQUIRE(sv.size() == 1);
+		REQUIRE(sv.at(0) == 'x');
+	}
+	REQUIRE(fsv::filtered_string_view{s, ~fsv::char_set::space()}.empty());
+	REQUIRE(fsv::filtered_string_view{s, fsv::char_set::space()}.size() == 1000);
+}
+
+TEST_CASE("Test comparison matches comparing the filtered strings") {
+	auto s = std::string{};
+	for (int i = 0; i < 1500; ++i) {
+		s += static_cast<char>((i * 7919) % 256);
+	}
+	auto lower_or_high = fsv::char_set::lower() | fsv::char_set::range('\x80', '\xff');
+	auto opaque = [](const char& c) { return (c >= 'a' && c <= 'z') || static_cast<unsigned char>(c) >= 0x80; };
+	for (std::size_t len : {0u, 1u, 100u, 255u, 256u, 257u, 1000u}) {
+		auto lhs = s.substr(0, len);
+		for (std::size_t pos : {0u, 1u, 200u, 256u, 700u}) {
+			auto rhs = lhs;
+			if (pos < rhs.size()) {
+				rhs[pos] = static_cast<char>(rhs[pos] + 1);
+			}
+			auto a = std::string{};
+			auto b = std::string{};
+			std::copy_if(lhs.begin(), lhs.end(), std::back_inserter(a), lower_or_high);
+			std::copy_if(rhs.begin(), rhs.end(), std::back_inserter(b), lower_or_high);
+
+			auto tl = fsv::filtered_string_view{lhs, lower_or_high};
+			auto tr = fsv::filtered_string_view{rhs, lower_or_high};
+			auto ol = fsv::filtered_string_view{lhs, opaque};
+			auto or_ = fsv::basic_filtered_string_view<decltype(opaque)>{rhs, opaque};
+			REQUIRE((tl <=> tr) == (a <=> b));
+			REQUIRE((tl == tr) == (a == b));
+			REQUIRE((ol <=> tr) == (a <=> b));
+			REQUIRE((tl <=> or_) == (a <=> b));
+			REQUIRE((or_ == ol) == (b == a));
+		}
+	}
+}
+
+TEST_CASE("Test comparison stops at the first difference") {
+	auto calls = 0;
+	auto counted = [&calls](const char&) {
+		++calls;
+		return true;
+	};
+	auto s = std::string{"b"}.append(10000, 'x');
+	auto lhs = fsv::filtered_string_view{s, counted};
+	auto rhs = fsv::filtered_string_view{"a"};
+	REQUIRE(lhs > rhs);
+	REQUIRE(calls == 1);
+	REQUIRE(lhs != rhs);
+	REQUIRE(calls == 2);
+
+	auto prefix = fsv::filtered_string_view{"ab", fsv::char_set::all()};
+	auto longer = fsv::filtered_string_view{"abc", fsv::char_set::all()};
+	REQUIRE(prefix < longer);
+	REQUIRE(fsv::filtered_string_view{"\xff"} > fsv::filtered_string_view{"a"});
+}
+
+TEST_CASE("Test equality skips reading when cached sizes differ") {
+	auto calls = 0;
+	auto counted = [&calls](const char& c) {
+		++calls;
+		return c != '-';
+	};
+	auto s = std::string{"ab-c"};
+	auto t = std::string{"abc-d"};
+	auto lhs = fsv::filtered_string_view{s, counted};
+	auto rhs = fsv::filtered_string_view{t, counted};
+	auto same = fsv::basic_filtered_string_view<fsv::char_set>{"abc", fsv::char_set::all()};
+	REQUIRE(lhs.size() == 3);
+	REQUIRE(rhs.size() == 4);
+	calls = 0;
+	REQUIRE_FALSE(lhs == rhs);
+	REQUIRE(lhs != rhs);
+	REQUIRE(calls == 0);
+
+	// equal sizes, or one unknown, still compare the characters
+	REQUIRE(lhs == same);
+	REQUIRE(calls > 0);
+	REQUIRE(same.size() == 3);
+	REQUIRE(lhs == same);
+	REQUIRE_FALSE(fsv::filtered_string_view{"abd"} == lhs);
+}
+
+TEST_CASE("Test split returns views into the original buffer") {
+	auto s = std::string{"a,-b,,c-,"};
+	auto sv = fsv::filtered_string_view{s, [](const char& c) { return c != '-'; }};
+	auto v = fsv::split(sv, ",");
+	REQUIRE(v == std::vector<fsv::filtered_string_view>{"a", "b", "", "c", ""});
+	for (const auto& token : v) {
+		REQUIRE(token.data() >= s.data());
+		REQUIRE(token.data() + token.source_size() <= s.data() + s.size());
+	}
+	// each token is bounded by its own source range
+	REQUIRE(v[1].data() == s.data() + 2);
+	REQUIRE(v[1].source_size() == 2);
+	REQUIRE(std::distance(v[2].begin(), v[2].end()) == 0);
+}
+
+TEST_CASE("Test split edge cases") {
+	auto sv = fsv::filtered_string_view{"a::b::", fsv::char_set::of("ab:")};
+	REQUIRE(fsv::split(sv, "::") == std::vector<fsv::filtered_string_view>{"a", "b", ""});
+	REQUIRE(fsv::split(sv, "") == std::vector<fsv::filtered_string_view>{sv});
+	REQUIRE(fsv::split(sv, "x") == std::vector<fsv::filtered_string_view>{sv});
+	REQUIRE(fsv::split(fsv::filtered_string_view{""}, "x") == std::vector<fsv::filtered_string_view>{""});
+	// a delimiter can span filtered-out characters
+	auto spaced = fsv::filtered_string_view{"1-:-:2", [](const char& c) { return c != '-'; }};
+	REQUIRE(fsv::split(spaced, "::") == std::vector<fsv::filtered_string_view>{"1", "2"});
+}
+
+TEST_CASE("Test split matches a naive split of the filtered string") {
+	// split the filtered characters on every non-overlapping occurrence, left to right
+	auto naive_split = [](const std::string& s, const std::string& delim) {
+		auto tokens = std::vector<std::string>{};
+		std::size_t first = 0;
+		for (auto at = s.find(delim); at != std::string::npos; at = s.find(delim, first)) {
+			tokens.push_back(s.substr(first, at - first));
+			first = at + delim.size();
+		}
+		tokens.push_back(s.substr(first));
+		return tokens;
+	};
+	auto no_dash = [](const char& c) { return c != '-'; };
+	// every string of up to 7 chars over "ab-", against delimiters that overlap themselves
+	auto s = std::string{};
+	for (std::size_t n = 0; n <= 7; n++) {
+		auto digits = std::vector<std::size_t>(n, 0);
+		while (true) {
+			s.clear();
+			for (auto d : digits) {
+				s.push_back("ab-"[d]);
+			}
+			for (const auto* delim : {"a", "-", "aa", "ab", "aab", "aba"}) {
+				const auto table = fsv::filtered_string_view{s, fsv::char_set::of("ab")};
+				const auto opaque = fsv::filtered_string_view{s, no_dash};
+				const auto expected = naive_split(static_cast<std::string>(opaque), delim);
+				for (const auto& sv : {table, opaque}) {
+					const auto tokens = fsv::split(sv, delim);
+					auto got = std::vector<std::string>{};
+					for (const auto& token : tokens) {
+						got.push_back(static_cast<std::string>(token));
+					}
+					if (delim == std::string{"-"}) {
+						REQUIRE(got == std::vector<std::string>{static_cast<std::string>(sv)});
+					}
+					else {
+						REQUIRE(got == expected);
+					}
+				}
+			}
+			auto k = std::size_t{0};
+			while (k < n && ++digits[k] == 3) {
+				digits[k++] = 0;
+			}
+			if (k == n) {
+				break;
+			}
+		}
+	}
+}
+
+TEST_CASE("Test split allocates little more than the result vector") {
+	auto s = std::string{};
+	for (int i = 0; i < 1000; i++) {
+		s += "x,";
+	}
+	const auto lambda = fsv::filtered_string_view{s, [](const char& c) { return c != ' '; }};
+	const auto table = fsv::filtered_string_view{s, ~fsv::char_set::of(" ")};
+
+	auto before = allocations.load();
+	const auto lambda_tokens = fsv::split(lambda, ",");
+	const auto lambda_allocations = allocations - before;
+	before = allocations;
+	const auto table_tokens = fsv::split(table, ",");
+	const auto table_allocations = allocations - before;
+
+	REQUIRE(lambda_tokens.size() == 1001);
+	REQUIRE(table_tokens.size() == 1001);
+	// the result vector's growth and the split state, but nothing per token
+	REQUIRE(lambda_allocations < 20);
+	REQUIRE(table_allocations < 20);
+	// the tokens still scan with the table
+	REQUIRE(fsv::detail::as_char_set(table_tokens[500].predicate()) != nullptr);
+	REQUIRE(table_tokens[500] == "x");
+	REQUIRE(fsv::compose(table_tokens[500], {fsv::char_set::of("x")}).predicate().target<fsv::char_set>() != nullptr);
+}
+
+TEST_CASE("Test split_view yields the tokens of split") {
+	auto sv = fsv::filtered_string_view{"a, b,, c,", [](const char& c) { return c != ' '; }};
+	static_assert(std::ranges::forward_range<fsv::split_view>);
+	static_assert(std::ranges::view<fsv::split_view>);
+	auto tokens = std::vector<fsv::filtered_string_view>{};
+	for (auto token : fsv::split_view{sv, ","}) {
+		tokens.push_back(token);
+	}
+	REQUIRE(tokens == fsv::split(sv, ","));
+	REQUIRE(tokens == std::vector<fsv::filtered_string_view>{"a", "b", "", "c", ""});
+	REQUIRE(std::ranges::distance(fsv::split_view{sv, ""}) == 1);
+	REQUIRE(std::ranges::distance(fsv::split_view{"", ","}) == 1);
+}
+
+TEST_CASE("Test split_view only scans as far as it is iterated") {
+	auto calls = 0;
+	auto counted = [&calls](const char&) {
+		++calls;
+		return true;
+	};
+	auto s = std::string{"id,name,"}.append(10000, 'x');
+	auto fields = fsv::split_view{{s, counted}, ","};
+	auto it = fields.begin();
+	REQUIRE(*it == "id");
+	++it;
+	REQUIRE(*it == "name");
+	REQUIRE(calls < 20);
+	auto first_two = fields | std::views::take(2);
+	REQUIRE(std::ranges::distance(first_two) == 2);
+}
+
+TEST_CASE("Test runs are the maximal stretches of kept characters") {
+	auto s = std::string{"ab\r\ncd\r\n\r\nef"};
+	auto no_cr = fsv::filtered_string_view{s, [](const char& c) { return c != '\r' && c != '\n'; }};
+	auto table = fsv::filtered_string_view{s, ~fsv::char_set::of("\r\n")};
+	static_assert(std::ranges::forward_range<fsv::filtered_string_view::run_range>);
+	for (const auto& sv : {no_cr, table}) {
+		auto runs = std::vector<std::string_view>{};
+		for (auto run : sv.runs()) {
+			runs.push_back(run);
+		}
+		REQUIRE(runs == std::vector<std::string_view>{"ab", "cd", "ef"});
+		REQUIRE(runs[1].data() == s.data() + 4);
+		REQUIRE(static_cast<std::string>(sv) == "abcdef");
+	}
+	REQUIRE(fsv::filtered_string_view{}.runs().empty());
+	REQUIRE(fsv::filtered_string_view{"\r\n", ~fsv::char_set::of("\r\n")}.runs().empty());
+}
+
+TEST_CASE("Test runs of a char_set view with short and long runs and gaps") {
+	// runs and gaps of every length up to 80, crossing the point where the SIMD search takes over
+	auto s = std::string{};
+	for (std::size_t n = 1; n <= 80; n++) {
+		s.append(n, 'a').append(81 - n, ' ');
+	}
+	const auto table = fsv::filtered_string_view{s, ~fsv::char_set::of(" ")};
+	const auto lambda = fsv::filtered_string_view{s, [](const char& c) { return c != ' '; }};
+	auto table_runs = std::vector<std::string_view>{};
+	for (auto run : table.runs()) {
+		table_runs.push_back(run);
+	}
+	auto lambda_runs = std::vector<std::string_view>{};
+	for (auto run : lambda.runs()) {
+		lambda_runs.push_back(run);
+	}
+	REQUIRE(table_runs.size() == 80);
+	REQUIRE(table_runs == lambda_runs);
+	REQUIRE(table_runs[79].data() == lambda_runs[79].data());
+}
+
+TEST_CASE("Test copy and hash use the filtered characters") {
+	auto sv = fsv::filtered_string_view{"a-bc--d-e", [](const char& c) { return c != '-'; }};
+	char buffer[8] = {};
+	REQUIRE(sv.copy(buffer, 3, 1) == 3);
+	REQUIRE(std::string_view{buffer, 3} == "bcd");
+	REQUIRE(sv.copy(buffer, 8) == 5);
+	REQUIRE(std::string_view{buffer, 5} == "abcde");
+	REQUIRE(sv.copy(buffer, 8, 5) == 0);
+	REQUIRE_THROWS_AS(sv.copy(buffer, 8, 6), std::out_of_range);
+	// nothing to copy, but pos is still checked
+	REQUIRE(sv.copy(buffer, 0, 1) == 0);
+	REQUIRE(sv.copy(buffer, 0, 5) == 0);
+	REQUIRE_THROWS_AS(sv.copy(buffer, 0, 6), std::out_of_range);
+	REQUIRE(fsv::filtered_string_view{"abc"}.copy(buffer, 0, 1) == std::string_view{"abc"}.copy(buffer, 0, 1));
+	// every count and pos against std::string::copy
+	const auto expected = std::string{"abcde"};
+	for (std::size_t count = 0; count <= 6; count++) {
+		for (std::size_t pos = 0; pos <= 5; pos++) {
+			char want[8] = {};
+			REQUIRE(sv.copy(buffer, count, pos) == expected.copy(want, count, pos));
+			REQUIRE(std::string_view{buffer, std::min(count, 5 - pos)} == std::string_view{want, std::min(count, 5 - pos)});
+		}
+	}
+
+	auto hash = std::hash<fsv::filtered_string_view>{};
+	REQUIRE(hash(sv) == hash(fsv::filtered_string_view{"abcde"}));
+	REQUIRE(hash(sv) != hash(fsv::filtered_string_view{"abcdf"}));
+	REQUIRE(hash(fsv::filtered_string_view{"abcde", fsv::char_set::all()}) == hash(sv));
+}
+
+TEST_CASE("Test output writes the runs straight to the stream") {
+	auto s = std::string(100000, 'a');
+	for (std::size_t i = 0; i < s.size(); i += 100) {
+		s[i] = '\r';
+	}
+	auto sv = fsv::filtered_string_view{s, [](const char& c) { return c != '\r'; }};
+	std::ostringstream oss;
+	oss << sv;
+	REQUIRE(oss.str() == static_cast<std::string>(sv));
+
+	std::ostringstream padded;
+	padded << std::setw(6) << fsv::filtered_string_view{"a-b", [](const char& c) { return c != '-'; }} << '|'
+	       << std::left << std::setw(4) << std::setfill('.') << fsv::filtered_string_view{"cd"} << '|';
+	REQUIRE(padded.str() == "    ab|cd..|");
+}
+
+TEST_CASE("Test output of a char_set view made of short runs") {
+	// word-like text: runs of 1 to 8 kept characters between single spaces
+	auto s = std::string{};
+	for (std::size_t i = 0; s.size() < 10000; i++) {
+		s.append(i % 8 + 1, static_cast<char>('a' + i % 26)).push_back(' ');
+	}
+	const auto words = fsv::filtered_string_view{s, ~fsv::char_set::of(" ")};
+	const auto expected = static_cast<std::string>(words);
+	std::ostringstream oss;
+	oss << words;
+	REQUIRE(oss.str() == expected);
+
+	std::ostringstream padded;
+	padded << std::setfill('*') << std::setw(static_cast<int>(expected.size() + 2)) << words;
+	REQUIRE(padded.str() == "**" + expected);
+}
+
+TEST_CASE("Test substr is a flat source range with the parent predicate") {
+	auto s = std::string{"a-b-c-d-e-f"};
+	auto sv = fsv::filtered_string_view{s, ~fsv::char_set::of("-")};
+	auto sub = fsv::substr(sv, 1, 4);
+	REQUIRE(sub == "bcde");
+	REQUIRE(sub.data() == s.data() + 2);
+	REQUIRE(sub.source_size() == 8);
+	REQUIRE(sub.predicate().target<fsv::char_set>() != nullptr);
+
+	auto nested = fsv::substr(fsv::substr(sub, 1), 1, 1);
+	REQUIRE(nested == "d");
+	REQUIRE(nested.data() == s.data() + 6);
+	REQUIRE(nested.predicate().target<fsv::char_set>() != nullptr);
+	REQUIRE(fsv::substr(sv, 5) == "f");
+	REQUIRE(fsv::substr(sv, 6).empty());
+}
+
+TEST_CASE("Test compose keeps the source range of substr and split results") {
+	auto sv = fsv::filtered_string_view{"abcdef"};
+	auto sub = fsv::substr(sv, 1, 2);
+	REQUIRE(fsv::compose(sub, {}) == "bc");
+	REQUIRE(fsv::compose(sub, {fsv::char_set::of("c")}) == "c");
+	REQUIRE(fsv::compose(sub, {[](const char& c) { return c != 'b'; }}) == "c");
+
+	auto tokens = fsv::split(fsv::filtered_string_view{"ab,cd,ef"}, ",");
+	REQUIRE(fsv::compose(tokens[1], {fsv::char_set::alpha()}) == "cd");
+	REQUIRE(fsv::compose(tokens[1], {fsv::char_set::alpha(), [](const char& c) { return c != 'c'; }}) == "d");
+	REQUIRE(fsv::compose(tokens[0], {}).source_size() == 2);
+}
+
+TEST_CASE("Test iteration is bounded by the source range") {
+	// embedded NULs are ordinary characters
+	auto binary = std::string{"a\0b\0\0c", 6};
+	auto sv = fsv::filtered_string_view{binary, [](const char& c) { return c != 'b'; }};
+	REQUIRE(std::string(sv.begin(), sv.end()) == std::string{"a\0\0\0c", 5});
+	REQUIRE(std::string(sv.rbegin(), sv.rend()) == std::string{"c\0\0\0a", 5});
+
+	// an unterminated buffer, exactly sized so that reading outside it is caught by the sanitizers
+	auto buffer = std::make_unique<char[]>(5);
+	std::memcpy(buffer.get(), "-xy-z", 5);
+	auto bounded = fsv::filtered_string_view{buffer.get(), 5, ~fsv::char_set::of("-")};
+	REQUIRE(std::string(bounded.begin(), bounded.end()) == "xyz");
+	REQUIRE(std::string(bounded.rbegin(), bounded.rend()) == "zyx");
+	auto trailing = fsv::filtered_string_view{buffer.get(), 4, [](const char& c) { return c != '-'; }};
+	REQUIRE(std::string(trailing.begin(), trailing.end()) == "xy");
+	REQUIRE(*--trailing.end() == 'y');
+}
+
+TEST_CASE("Test iteration over a char_set view skips gaps of any length") {
+	// gaps of every length up to 80, crossing the point where the SIMD search takes over
+	auto s = std::string{};
+	for (std::size_t n = 0; n <= 80; n++) {
+		s.append(n, ' ').push_back(static_cast<char>('a' + n % 26));
+	}
+	s.append(40, ' ');
+	const auto table = fsv::filtered_string_view{s, ~fsv::char_set::of(" ")};
+	const auto lambda = fsv::filtered_string_view{s, [](const char& c) { return c != ' '; }};
+	REQUIRE(std::string(table.begin(), table.end()) == std::string(lambda.begin(), lambda.end()));
+	REQUIRE(std::distance(table.begin(), table.end()) == 81);
+}
+
+TEST_CASE("Test constructors from length-delimited buffers") {
+	auto packet = std::string_view{"GET /index HTTP/1.1"};
+	auto method = fsv::filtered_string_view{packet.substr(0, 3)};
+	REQUIRE(method == "GET");
+	REQUIRE(method.source_size() == 3);
+	auto path = fsv::filtered_string_view{packet.substr(4, 6), fsv::char_set::alpha()};
+	REQUIRE(path == "index");
+
+	auto payload = std::vector<char>{'a', '\0', 'b', '\r', 'c'};
+	auto bytes = fsv::filtered_string_view{std::span<const char>{payload}};
+	REQUIRE(bytes.size() == 5);
+	auto text = fsv::filtered_string_view{payload, [](const char& c) { return c != '\0' && c != '\r'; }};
+	REQUIRE(text == "abc");
+	REQUIRE(fsv::filtered_string_view{payload.data(), 2} == std::string_view{"a\0", 2});
+	auto digits = fsv::basic_filtered_string_view<fsv::char_set>{std::string_view{"x1y2"}, fsv::char_set::digit()};
+	REQUIRE(static_cast<std::string>(digits) == "12");
+}
+
+TEST_CASE("Test compose of views over unterminated buffers") {
+	// exactly sized heap buffers with no terminator, so the sanitizers catch a read past the end
+	auto buffer = std::make_unique<char[]>(4);
+	std::memcpy(buffer.get(), "ab1c", 4);
+	const auto from_view = fsv::filtered_string_view{std::string_view{buffer.get(), 4}};
+	REQUIRE(fsv::compose(from_view, {fsv::char_set::alpha()}) == "abc");
+	const auto from_span = fsv::filtered_string_view{std::span<const char>{buffer.get(), 4}, fsv::char_set::alnum()};
+	REQUIRE(fsv::compose(from_span, {[](const char& c) { return c != 'b'; }}) == "a1c");
+	const auto from_pointer = fsv::filtered_string_view{buffer.get(), 3};
+	REQUIRE(fsv::compose(from_pointer, {fsv::char_set::alpha(), [](const char& c) { return c != 'a'; }}) == "b");
+	REQUIRE(fsv::compose(from_pointer, {}).source_size() == 3);
+}
+
+TEST_CASE("Test literal_view filters literals at compile time") {
+	constexpr auto keyword = fsv::filter_literal("else-if", fsv::char_set::alpha());
+	static_assert(keyword == "elseif");
+	static_assert(keyword.size() == 6);
+	static_assert(keyword.capacity() == 7);
+	static_assert(keyword < "elsf");
+
+	constexpr auto upper = fsv::literal_view{"Content-Type", [](char c) { return c >= 'A' && c <= 'Z'; }};
+	static_assert(upper.size() == 2);
+	static_assert(upper[1] == 'T');
+	static_assert(upper == "CT");
+	static_assert(fsv::literal_view{"--", fsv::char_set::alpha()}.empty());
+	static_assert(fsv::literal_view{"a-b", ~fsv::char_set::of("-")} == fsv::literal_view{"ab"});
+	static_assert(fsv::literal_view{"\xff"} > fsv::literal_view{"a"});
+
+	// the result can seed a runtime view
+	auto sv = fsv::filtered_string_view{keyword.view(), fsv::char_set::of("ef")};
+	REQUIRE(sv == "eef");
+	REQUIRE_THROWS_AS(upper.at(2), std::domain_error);
+	REQUIRE_THROWS_AS(upper.to_fixed<1>(), std::length_error);
+}
+
+TEST_CASE("Test find and rfind match std::string on the filtered characters") {
+	auto s = std::string{};
+	for (int i = 0; i < 3000; ++i) {
+		s += "ab-c\r"[(i * 7 + i / 5) % 5];
+	}
+	auto no_cr = [](const char& c) { return c != '\r'; };
+	auto opaque = fsv::filtered_string_view{s, no_cr};
+	auto table = fsv::filtered_string_view{s, ~fsv::char_set::of("\r")};
+	const auto expected = static_cast<std::string>(opaque);
+	for (std::string_view needle : {"", "a", "c", "ab", "ba-", "cab", "abab", "-ca-c", "zz", "b-cab-cb"}) {
+		for (std::size_t pos : {std::size_t{0}, std::size_t{1}, std::size_t{100}, expected.size() - 3,
+		                        expected.size(), expected.size() + 1, fsv::filtered_string_view::npos})
+		{
+			REQUIRE(opaque.find(needle, pos) == expected.find(needle, pos));
+			REQUIRE(table.find(needle, pos) == expected.find(needle, pos));
+			REQUIRE(opaque.rfind(needle, pos) == expected.rfind(needle, pos));
+			REQUIRE(table.rfind(needle, pos) == expected.rfind(needle, pos));
+		}
+	}
+}
+
+TEST_CASE("Test find and rfind leave the position index alone") {
+	auto s = std::string{};
+	for (int i = 0; i < 1000; ++i) {
+		s += "xy-zx\r"[(i * 5 + i / 7) % 6];
+	}
+	const auto expected = static_cast<std::string>(fsv::filtered_string_view{s, ~fsv::char_set::of("\r")});
+	auto table = fsv::filtered_string_view{s, ~fsv::char_set::of("\r")};
+	auto opaque = fsv::filtered_string_view{s, [](const char& c) { return c != '\r'; }};
+	for (auto* sv : {&table, &opaque}) {
+		REQUIRE(sv->find("zx", 0) == expected.find("zx", 0));
+		REQUIRE(sv->find("x-", 500) == expected.find("x-", 500));
+		REQUIRE(sv->rfind("y-", 700) == expected.rfind("y-", 700));
+		REQUIRE(sv->index_memory_usage() == 0);
+	}
+
+	// an index that is already built still answers where the search starts
+	for (auto mode : {fsv::index_mode::offsets, fsv::index_mode::rank_select, fsv::index_mode::sparse}) {
+		table.set_index_mode(mode, 16);
+		REQUIRE(table[500] == expected[500]);
+		REQUIRE(table.index_memory_usage() > 0);
+		REQUIRE(table.find("x-", 500) == expected.find("x-", 500));
+		REQUIRE(table.find("zx", 333) == expected.find("zx", 333));
+		REQUIRE(table.rfind("y-", 700) == expected.rfind("y-", 700));
+	}
+}
+
+TEST_CASE("Test contains, starts_with and ends_with") {
+	auto line = fsv::filtered_string_view{"GET /index.html\r\n", ~fsv::char_set::of("\r\n")};
+	REQUIRE(line.starts_with("GET "));
+	REQUIRE_FALSE(line.starts_with("POST"));
+	REQUIRE(line.ends_with(".html"));
+	REQUIRE_FALSE(line.ends_with("\n"));
+	REQUIRE(line.contains("index"));
+	REQUIRE_FALSE(line.contains("\r"));
+	REQUIRE(line.starts_with(""));
+	REQUIRE(line.ends_with(""));
+
+	auto spaced = fsv::filtered_string_view{"e r r o r", [](const char& c) { return c != ' '; }};
+	REQUIRE(spaced.contains("rro"));
+	REQUIRE(spaced.find("ror") == 2);
+	REQUIRE_FALSE(spaced.starts_with("errors"));
+	REQUIRE(fsv::filtered_string_view{}.find("") == 0);
+	REQUIRE_FALSE(fsv::filtered_string_view{}.contains("a"));
+}
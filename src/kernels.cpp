@@ -0,0 +1,601 @@
+#include "./kernels.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FSV_KERNELS_X86 1
+#endif
+
+namespace fsv::detail {
+	namespace {
+		// Scalar kernels
+		// the loops behind them, which the free functions also run on short spans
+		std::size_t compact_bytes(const char_set& set, const char* src, std::size_t n, char* dst) noexcept {
+			std::size_t out = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				if (set.contains(src[i])) {
+					dst[out++] = src[i];
+				}
+			}
+			return out;
+		}
+		std::size_t count_bytes(const char_set& set, const char* src, std::size_t n) noexcept {
+			std::size_t total = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				total += static_cast<std::size_t>(set.contains(src[i]));
+			}
+			return total;
+		}
+		std::size_t find_first_byte(const char_set& set, const char* src, std::size_t n) noexcept {
+			std::size_t i = 0;
+			while (i < n && !set.contains(src[i])) {
+				++i;
+			}
+			return i;
+		}
+
+		std::size_t compact_scalar(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t) noexcept {
+			return compact_bytes(set.set, src, n, dst);
+		}
+		std::size_t count_scalar(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			return count_bytes(set.set, src, n);
+		}
+		std::size_t find_first_scalar(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			return find_first_byte(set.set, src, n);
+		}
+
+#ifdef FSV_KERNELS_X86
+		// pshufb indices that move the bytes selected by an 8-bit mask to the front; 0x80 zeroes the rest
+		constexpr auto make_compact_shuffles() -> std::array<std::uint64_t, 256> {
+			auto table = std::array<std::uint64_t, 256>{};
+			for (unsigned mask = 0; mask < 256; ++mask) {
+				auto entry = std::uint64_t{0x8080808080808080};
+				auto k = 0u;
+				for (unsigned b = 0; b < 8; ++b) {
+					if (((mask >> b) & 1) != 0) {
+						entry &= ~(std::uint64_t{0xff} << (8 * k));
+						entry |= std::uint64_t{b} << (8 * k);
+						++k;
+					}
+				}
+				table[mask] = entry;
+			}
+			return table;
+		}
+		constexpr auto compact_shuffles = make_compact_shuffles();
+
+		// bits [0, n) set, for masking the lanes of a partial vector
+		constexpr auto low_bits(std::size_t n) noexcept -> std::uint64_t {
+			return n >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << n) - 1;
+		}
+
+		// SSE2 kernels
+		// SSE2 has no byte shuffle to look bytes up in a table with, so only compact has an SSE2
+		// version: it tests bytes one at a time but moves whole blocks with vector loads and stores.
+		// count and find_first at this level are the scalar kernels.
+		inline auto keep_mask_sse2(const char* src, const char_set& set) noexcept -> unsigned {
+			auto mask = 0u;
+			for (unsigned k = 0; k < 16; ++k) {
+				mask |= unsigned{set.contains(src[k])} << k;
+			}
+			return mask;
+		}
+		// write the kept bytes of src[0, 16) to out, which has room for 16 bytes, without branching
+		inline auto compact16_sse2(const char* src, const char_set& set, char* out) noexcept -> std::size_t {
+			std::size_t count = 0;
+			for (unsigned k = 0; k < 16; ++k) {
+				out[count] = src[k];
+				count += static_cast<std::size_t>(set.contains(src[k]));
+			}
+			return count;
+		}
+
+		__attribute__((target("sse2"))) std::size_t
+		compact_sse2(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept {
+			std::size_t out = 0;
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const auto mask = keep_mask_sse2(src + i, set.set);
+				if (mask == 0) {
+					continue;
+				}
+				if (out + 16 > dst_size) {
+					char tmp[16];
+					const auto count = compact16_sse2(src + i, set.set, tmp);
+					std::memcpy(dst + out, tmp, count);
+					out += count;
+				}
+				else if (mask == 0xffff) {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + out),
+					                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+					out += 16;
+				}
+				else {
+					out += compact16_sse2(src + i, set.set, dst + out);
+				}
+			}
+			return out + compact_bytes(set.set, src + i, n - i, dst + out);
+		}
+
+		// SSE4.2 kernels
+		__attribute__((target("sse4.2"))) inline auto load_rows_sse42(const std::array<std::uint8_t, 16>& rows) noexcept
+		   -> __m128i {
+			return _mm_load_si128(reinterpret_cast<const __m128i*>(rows.data()));
+		}
+		// the n < 16 bytes at src, zero padded, without reading past them
+		__attribute__((target("sse4.2"))) inline auto load_tail_sse42(const char* src, std::size_t n) noexcept
+		   -> __m128i {
+			alignas(16) char buf[16] = {};
+			std::memcpy(buf, src, n);
+			return _mm_load_si128(reinterpret_cast<const __m128i*>(buf));
+		}
+		// one bit per byte of x that is in the set
+		__attribute__((target("sse4.2"))) inline auto
+		keep_mask_sse42(__m128i x, __m128i low_rows, __m128i high_rows) noexcept -> unsigned {
+			const auto nibble = _mm_set1_epi8(0x0f);
+			const auto lo = _mm_and_si128(x, nibble);
+			const auto hi = _mm_and_si128(_mm_srli_epi16(x, 4), nibble);
+			// the top bit of each byte of x picks the row table
+			const auto row = _mm_blendv_epi8(_mm_shuffle_epi8(low_rows, lo), _mm_shuffle_epi8(high_rows, lo), x);
+			const auto bit = _mm_shuffle_epi8(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128), hi);
+			return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit)));
+		}
+		// write the bytes of x selected by mask to out, which has room for 16 bytes
+		__attribute__((target("sse4.2"))) inline auto compact16(__m128i x, unsigned mask, char* out) noexcept
+		   -> std::size_t {
+			const auto lo_mask = mask & 0xff;
+			const auto hi_mask = (mask >> 8) & 0xff;
+			const auto lo_shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&compact_shuffles[lo_mask]));
+			const auto hi_shuffle = _mm_add_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&compact_shuffles[hi_mask])),
+			                                     _mm_set1_epi8(8));
+			const auto lo_count = static_cast<std::size_t>(std::popcount(lo_mask));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(x, lo_shuffle));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + lo_count), _mm_shuffle_epi8(x, hi_shuffle));
+			return lo_count + static_cast<std::size_t>(std::popcount(hi_mask));
+		}
+		// compact16 for the last few output bytes, where a 16-byte store would overrun dst
+		__attribute__((target("sse4.2"))) inline auto compact16_tail(__m128i x, unsigned mask, char* out) noexcept
+		   -> std::size_t {
+			char tmp[16];
+			const auto count = compact16(x, mask, tmp);
+			std::memcpy(out, tmp, count);
+			return count;
+		}
+
+		__attribute__((target("sse4.2"))) std::size_t
+		compact_sse42(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept {
+			const auto low_rows = load_rows_sse42(set.low_rows);
+			const auto high_rows = load_rows_sse42(set.high_rows);
+			std::size_t out = 0;
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				const auto mask = keep_mask_sse42(x, low_rows, high_rows);
+				if (mask == 0) {
+					continue;
+				}
+				if (out + 16 > dst_size) {
+					out += compact16_tail(x, mask, dst + out);
+				}
+				else if (mask == 0xffff) {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + out), x);
+					out += 16;
+				}
+				else {
+					out += compact16(x, mask, dst + out);
+				}
+			}
+			if (i < n) {
+				const auto x = load_tail_sse42(src + i, n - i);
+				const auto mask = keep_mask_sse42(x, low_rows, high_rows) & static_cast<unsigned>(low_bits(n - i));
+				out += compact16_tail(x, mask, dst + out);
+			}
+			return out;
+		}
+
+		__attribute__((target("sse4.2"))) std::size_t
+		count_sse42(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			const auto low_rows = load_rows_sse42(set.low_rows);
+			const auto high_rows = load_rows_sse42(set.high_rows);
+			std::size_t total = 0;
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				total += static_cast<std::size_t>(std::popcount(keep_mask_sse42(x, low_rows, high_rows)));
+			}
+			if (i < n) {
+				const auto mask = keep_mask_sse42(load_tail_sse42(src + i, n - i), low_rows, high_rows);
+				total += static_cast<std::size_t>(std::popcount(mask & static_cast<unsigned>(low_bits(n - i))));
+			}
+			return total;
+		}
+
+		__attribute__((target("sse4.2"))) std::size_t
+		find_first_sse42(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			const auto low_rows = load_rows_sse42(set.low_rows);
+			const auto high_rows = load_rows_sse42(set.high_rows);
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				if (const auto mask = keep_mask_sse42(x, low_rows, high_rows); mask != 0) {
+					return i + static_cast<std::size_t>(std::countr_zero(mask));
+				}
+			}
+			if (i < n) {
+				const auto mask = keep_mask_sse42(load_tail_sse42(src + i, n - i), low_rows, high_rows)
+				                  & static_cast<unsigned>(low_bits(n - i));
+				if (mask != 0) {
+					return i + static_cast<std::size_t>(std::countr_zero(mask));
+				}
+			}
+			return n;
+		}
+
+		// AVX2 kernels
+		__attribute__((target("avx2"))) inline auto load_rows_avx2(const std::array<std::uint8_t, 16>& rows) noexcept
+		   -> __m256i {
+			return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(rows.data())));
+		}
+		// the n < 32 bytes at src, zero padded, without reading past them
+		__attribute__((target("avx2"))) inline auto load_tail_avx2(const char* src, std::size_t n) noexcept -> __m256i {
+			alignas(32) char buf[32] = {};
+			std::memcpy(buf, src, n);
+			return _mm256_load_si256(reinterpret_cast<const __m256i*>(buf));
+		}
+		__attribute__((target("avx2"))) inline auto
+		keep_mask_avx2(__m256i x, __m256i low_rows, __m256i high_rows) noexcept -> std::uint32_t {
+			const auto nibble = _mm256_set1_epi8(0x0f);
+			const auto lo = _mm256_and_si256(x, nibble);
+			const auto hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+			const auto row =
+			   _mm256_blendv_epi8(_mm256_shuffle_epi8(low_rows, lo), _mm256_shuffle_epi8(high_rows, lo), x);
+			const auto bit = _mm256_shuffle_epi8(_mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+			                                                      1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128),
+			                                     hi);
+			return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit)));
+		}
+		// write the bytes of x selected by mask to dst + out, going through a buffer near the end of dst
+		__attribute__((target("avx2"))) inline auto
+		compact32_avx2(__m256i x, std::uint32_t mask, char* dst, std::size_t out, std::size_t dst_size) noexcept
+		   -> std::size_t {
+			if (out + 32 > dst_size) {
+				out += compact16_tail(_mm256_castsi256_si128(x), mask & 0xffff, dst + out);
+				out += compact16_tail(_mm256_extracti128_si256(x, 1), mask >> 16, dst + out);
+			}
+			else if (mask == 0xffffffff) {
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + out), x);
+				out += 32;
+			}
+			else {
+				out += compact16(_mm256_castsi256_si128(x), mask & 0xffff, dst + out);
+				out += compact16(_mm256_extracti128_si256(x, 1), mask >> 16, dst + out);
+			}
+			return out;
+		}
+
+		__attribute__((target("avx2"))) std::size_t
+		compact_avx2(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept {
+			const auto low_rows = load_rows_avx2(set.low_rows);
+			const auto high_rows = load_rows_avx2(set.high_rows);
+			std::size_t out = 0;
+			std::size_t i = 0;
+			for (; i + 32 <= n; i += 32) {
+				const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+				if (const auto mask = keep_mask_avx2(x, low_rows, high_rows); mask != 0) {
+					out = compact32_avx2(x, mask, dst, out, dst_size);
+				}
+			}
+			if (i < n) {
+				const auto x = load_tail_avx2(src + i, n - i);
+				const auto mask = keep_mask_avx2(x, low_rows, high_rows) & static_cast<std::uint32_t>(low_bits(n - i));
+				out = compact32_avx2(x, mask, dst, out, dst_size);
+			}
+			return out;
+		}
+
+		// keep mask of 64 bytes, one cache line
+		__attribute__((target("avx2"))) inline auto
+		keep_mask64_avx2(const char* src, __m256i low_rows, __m256i high_rows) noexcept -> std::uint64_t {
+			const auto lo = keep_mask_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), low_rows, high_rows);
+			const auto hi =
+			   keep_mask_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32)), low_rows, high_rows);
+			return std::uint64_t{lo} | (std::uint64_t{hi} << 32);
+		}
+		// keep mask of the n < 64 bytes at src
+		__attribute__((target("avx2"))) inline auto
+		keep_mask_tail_avx2(const char* src, std::size_t n, __m256i low_rows, __m256i high_rows) noexcept
+		   -> std::uint64_t {
+			if (n < 32) {
+				return keep_mask_avx2(load_tail_avx2(src, n), low_rows, high_rows) & low_bits(n);
+			}
+			const auto lo = keep_mask_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), low_rows, high_rows);
+			const auto hi = keep_mask_avx2(load_tail_avx2(src + 32, n - 32), low_rows, high_rows) & low_bits(n - 32);
+			return std::uint64_t{lo} | (hi << 32);
+		}
+
+		__attribute__((target("avx2"))) std::size_t count_avx2(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			const auto low_rows = load_rows_avx2(set.low_rows);
+			const auto high_rows = load_rows_avx2(set.high_rows);
+			std::size_t total = 0;
+			std::size_t i = 0;
+			for (; i + 64 <= n; i += 64) {
+				total += static_cast<std::size_t>(std::popcount(keep_mask64_avx2(src + i, low_rows, high_rows)));
+			}
+			if (i < n) {
+				total += static_cast<std::size_t>(std::popcount(keep_mask_tail_avx2(src + i, n - i, low_rows, high_rows)));
+			}
+			return total;
+		}
+
+		__attribute__((target("avx2"))) std::size_t
+		find_first_avx2(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			const auto low_rows = load_rows_avx2(set.low_rows);
+			const auto high_rows = load_rows_avx2(set.high_rows);
+			std::size_t i = 0;
+			for (; i + 64 <= n; i += 64) {
+				if (const auto mask = keep_mask64_avx2(src + i, low_rows, high_rows); mask != 0) {
+					return i + static_cast<std::size_t>(std::countr_zero(mask));
+				}
+			}
+			if (i < n) {
+				if (const auto mask = keep_mask_tail_avx2(src + i, n - i, low_rows, high_rows); mask != 0) {
+					return i + static_cast<std::size_t>(std::countr_zero(mask));
+				}
+			}
+			return n;
+		}
+
+		// AVX-512BW kernels
+		// GCC 12's 512-bit intrinsics start from a deliberately undefined vector, which -O2 reports as
+		// uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+		__attribute__((target("avx512bw"))) inline auto
+		keep_mask_avx512bw(__m512i x, __m512i low_rows, __m512i high_rows) noexcept -> std::uint64_t {
+			const auto nibble = _mm512_set1_epi8(0x0f);
+			const auto lo = _mm512_and_si512(x, nibble);
+			const auto hi = _mm512_and_si512(_mm512_srli_epi16(x, 4), nibble);
+			const auto row =
+			   _mm512_mask_blend_epi8(_mm512_movepi8_mask(x), _mm512_shuffle_epi8(low_rows, lo), _mm512_shuffle_epi8(high_rows, lo));
+			const auto bit = _mm512_shuffle_epi8(
+			   _mm512_broadcast_i32x4(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128)),
+			   hi);
+			return _mm512_test_epi8_mask(row, bit);
+		}
+		__attribute__((target("avx512bw"))) inline auto load_rows_avx512bw(const std::array<std::uint8_t, 16>& rows) noexcept
+		   -> __m512i {
+			return _mm512_broadcast_i32x4(_mm_load_si128(reinterpret_cast<const __m128i*>(rows.data())));
+		}
+		// the n < 64 bytes at src, zero padded; masked-off bytes are never read
+		__attribute__((target("avx512bw"))) inline auto load_tail_avx512bw(const char* src, std::size_t n) noexcept
+		   -> __m512i {
+			return _mm512_maskz_loadu_epi8(low_bits(n), src);
+		}
+
+		__attribute__((target("avx512bw"))) std::size_t
+		compact_avx512bw(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept {
+			const auto low_rows = load_rows_avx512bw(set.low_rows);
+			const auto high_rows = load_rows_avx512bw(set.high_rows);
+			std::size_t out = 0;
+			for (std::size_t i = 0; i < n; i += 64) {
+				const auto tail = n - i < 64;
+				const auto x = tail ? load_tail_avx512bw(src + i, n - i) : _mm512_loadu_si512(src + i);
+				const auto mask = keep_mask_avx512bw(x, low_rows, high_rows) & low_bits(n - i);
+				if (mask == 0) {
+					continue;
+				}
+				if (mask == ~std::uint64_t{0} && out + 64 <= dst_size) {
+					_mm512_storeu_si512(dst + out, x);
+					out += 64;
+					continue;
+				}
+				const __m128i lanes[] = {_mm512_extracti32x4_epi32(x, 0),
+				                         _mm512_extracti32x4_epi32(x, 1),
+				                         _mm512_extracti32x4_epi32(x, 2),
+				                         _mm512_extracti32x4_epi32(x, 3)};
+				for (unsigned lane = 0; lane < 4; ++lane) {
+					const auto lane_mask = static_cast<unsigned>((mask >> (16 * lane)) & 0xffff);
+					out += out + 16 > dst_size ? compact16_tail(lanes[lane], lane_mask, dst + out)
+					                           : compact16(lanes[lane], lane_mask, dst + out);
+				}
+			}
+			return out;
+		}
+
+		__attribute__((target("avx512bw"))) std::size_t
+		count_avx512bw(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			const auto low_rows = load_rows_avx512bw(set.low_rows);
+			const auto high_rows = load_rows_avx512bw(set.high_rows);
+			std::size_t total = 0;
+			std::size_t i = 0;
+			for (; i + 64 <= n; i += 64) {
+				const auto mask = keep_mask_avx512bw(_mm512_loadu_si512(src + i), low_rows, high_rows);
+				total += static_cast<std::size_t>(std::popcount(mask));
+			}
+			if (i < n) {
+				const auto mask = keep_mask_avx512bw(load_tail_avx512bw(src + i, n - i), low_rows, high_rows);
+				total += static_cast<std::size_t>(std::popcount(mask & low_bits(n - i)));
+			}
+			return total;
+		}
+
+		__attribute__((target("avx512bw"))) std::size_t
+		find_first_avx512bw(const prepared_set& set, const char* src, std::size_t n) noexcept {
+			const auto low_rows = load_rows_avx512bw(set.low_rows);
+			const auto high_rows = load_rows_avx512bw(set.high_rows);
+			for (std::size_t i = 0; i < n; i += 64) {
+				const auto x = n - i < 64 ? load_tail_avx512bw(src + i, n - i) : _mm512_loadu_si512(src + i);
+				if (const auto mask = keep_mask_avx512bw(x, low_rows, high_rows) & low_bits(n - i); mask != 0) {
+					return i + static_cast<std::size_t>(std::countr_zero(mask));
+				}
+			}
+			return n;
+		}
+#pragma GCC diagnostic pop
+#endif
+
+		constexpr auto scalar_kernels = kernel_table{isa::scalar, compact_scalar, count_scalar, find_first_scalar};
+#ifdef FSV_KERNELS_X86
+		constexpr auto sse2_kernels = kernel_table{isa::sse2, compact_sse2, count_scalar, find_first_scalar};
+		constexpr auto sse42_kernels = kernel_table{isa::sse42, compact_sse42, count_sse42, find_first_sse42};
+		constexpr auto avx2_kernels = kernel_table{isa::avx2, compact_avx2, count_avx2, find_first_avx2};
+		constexpr auto avx512bw_kernels =
+		   kernel_table{isa::avx512bw, compact_avx512bw, count_avx512bw, find_first_avx512bw};
+#endif
+
+		// the best level this CPU runs, capped by FSV_ISA
+		auto select_isa() noexcept -> isa {
+			auto best = isa::scalar;
+			for (auto level : all_isas) {
+				if (kernels_for(level) != nullptr) {
+					best = level;
+				}
+			}
+			if (const char* name = std::getenv("FSV_ISA")) {
+				if (const auto cap = isa_from_name(name); cap && *cap < best) {
+					best = *cap;
+				}
+			}
+			return best;
+		}
+	} // namespace
+
+	std::string_view isa_name(isa level) noexcept {
+		switch (level) {
+		case isa::scalar: return "scalar";
+		case isa::sse2: return "sse2";
+		case isa::sse42: return "sse4.2";
+		case isa::avx2: return "avx2";
+		case isa::avx512bw: return "avx512bw";
+		}
+		return "scalar";
+	}
+	std::optional<isa> isa_from_name(std::string_view name) noexcept {
+		for (auto level : all_isas) {
+			if (isa_name(level) == name) {
+				return level;
+			}
+		}
+		return std::nullopt;
+	}
+
+	const kernel_table* kernels_for(isa level) noexcept {
+		switch (level) {
+		case isa::scalar: return &scalar_kernels;
+#ifdef FSV_KERNELS_X86
+		case isa::sse2: return __builtin_cpu_supports("sse2") ? &sse2_kernels : nullptr;
+		case isa::sse42: return __builtin_cpu_supports("sse4.2") ? &sse42_kernels : nullptr;
+		case isa::avx2: return __builtin_cpu_supports("avx2") ? &avx2_kernels : nullptr;
+		case isa::avx512bw: return __builtin_cpu_supports("avx512bw") ? &avx512bw_kernels : nullptr;
+#endif
+		default: return nullptr;
+		}
+	}
+	const kernel_table& active_kernels() noexcept {
+		static const auto* table = kernels_for(select_isa());
+		return *table;
+	}
+
+	prepared_set prepare(const char_set& set) noexcept {
+		auto prepared = prepared_set{};
+		prepared.set = set;
+		// Each word holds four rows of 16 chars. Bit k of a row sits at 16 * k + lo of the word once it
+		// is shifted by lo; the multiply gathers those four bits, without carries, into bits 48 to 51.
+		constexpr auto row_bits = std::uint64_t{0x0001000100010001};
+		constexpr auto gather = (std::uint64_t{1} << 48) | (std::uint64_t{1} << 33) | (std::uint64_t{1} << 18)
+		                        | (std::uint64_t{1} << 3);
+		const auto& words = set.words();
+		for (unsigned lo = 0; lo < 16; ++lo) {
+			auto nibble = [&words, lo](std::size_t w) {
+				return static_cast<unsigned>((((words[w] >> lo) & row_bits) * gather) >> 48) & 0xf;
+			};
+			prepared.low_rows[lo] = static_cast<std::uint8_t>(nibble(0) | (nibble(1) << 4));
+			prepared.high_rows[lo] = static_cast<std::uint8_t>(nibble(2) | (nibble(3) << 4));
+		}
+		return prepared;
+	}
+
+	std::size_t compact(const char_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept {
+		if (n < scalar_cutoff) {
+			return compact_bytes(set, src, n, dst);
+		}
+		return active_kernels().compact(prepare(set), src, n, dst, dst_size);
+	}
+	std::size_t compact(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept {
+		if (n < scalar_cutoff) {
+			return compact_bytes(set.set, src, n, dst);
+		}
+		return active_kernels().compact(set, src, n, dst, dst_size);
+	}
+	std::size_t count(const char_set& set, const char* src, std::size_t n) noexcept {
+		if (n < scalar_cutoff) {
+			return count_bytes(set, src, n);
+		}
+		return active_kernels().count(prepare(set), src, n);
+	}
+	std::size_t count(const prepared_set& set, const char* src, std::size_t n) noexcept {
+		if (n < scalar_cutoff) {
+			return count_bytes(set.set, src, n);
+		}
+		return active_kernels().count(set, src, n);
+	}
+	std::size_t find_first(const char_set& set, const char* src, std::size_t n) noexcept {
+		if (n < scalar_cutoff) {
+			return find_first_byte(set, src, n);
+		}
+		return active_kernels().find_first(prepare(set), src, n);
+	}
+	std::size_t find_first(const prepared_set& set, const char* src, std::size_t n) noexcept {
+		if (n < scalar_cutoff) {
+			return find_first_byte(set.set, src, n);
+		}
+		return active_kernels().find_first(set, src, n);
+	}
+	int compare(const char_set& lset, const char* lhs, std::size_t ln, const char_set& rset, const char* rhs,
+	            std::size_t rn) noexcept {
+		// a block of source never compacts to more than itself, so each refill fits its buffer
+		constexpr std::size_t block = 256;
+		const auto lprepared = prepare(lset);
+		const auto rprepared = prepare(rset);
+		char lbuf[block];
+		char rbuf[block];
+		// unread kept bytes are buf[pos, fill)
+		std::size_t lpos = 0;
+		std::size_t lfill = 0;
+		std::size_t rpos = 0;
+		std::size_t rfill = 0;
+		while (true) {
+			while (lpos == lfill && ln > 0) {
+				const auto take = std::min(block, ln);
+				lfill = compact(lprepared, lhs, take, lbuf, block);
+				lpos = 0;
+				lhs += take;
+				ln -= take;
+			}
+			while (rpos == rfill && rn > 0) {
+				const auto take = std::min(block, rn);
+				rfill = compact(rprepared, rhs, take, rbuf, block);
+				rpos = 0;
+				rhs += take;
+				rn -= take;
+			}
+			const bool lend = lpos == lfill;
+			const bool rend = rpos == rfill;
+			if (lend || rend) {
+				return static_cast<int>(rend) - static_cast<int>(lend);
+			}
+			const auto k = std::min(lfill - lpos, rfill - rpos);
+			if (const int diff = std::memcmp(lbuf + lpos, rbuf + rpos, k); diff != 0) {
+				return diff;
+			}
+			lpos += k;
+			rpos += k;
+		}
+	}
+} // namespace fsv::detail
@@ -0,0 +1,93 @@
+#ifndef COMP6771_ASS2_KERNELS_H
+#define COMP6771_ASS2_KERNELS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "./char_set.h"
+
+// Scanning kernels for table-backed predicates. Every kernel has a scalar reference implementation and
+// SIMD versions for several x86 levels; the best level the CPU supports is chosen at run time (through
+// cpuid) the first time a kernel runs. Setting the environment variable FSV_ISA to one of the names
+// below caps the level, e.g. FSV_ISA=scalar to force the reference code.
+namespace fsv::detail {
+	// instruction set levels, in increasing order
+	enum class isa {
+		scalar,
+		sse2,
+		sse42,
+		avx2,
+		avx512bw,
+	};
+	inline constexpr isa all_isas[] = {isa::scalar, isa::sse2, isa::sse42, isa::avx2, isa::avx512bw};
+
+	// "scalar", "sse2", "sse4.2", "avx2" or "avx512bw"
+	auto isa_name(isa level) noexcept -> std::string_view;
+	// the level with this name, if any
+	auto isa_from_name(std::string_view name) noexcept -> std::optional<isa>;
+
+	// A char_set with the tables the SIMD kernels look bytes up in. Building them is a pass over the
+	// set, so a caller scanning with the same set many times prepares it once.
+	struct prepared_set {
+		char_set set;
+		// pshufb tables indexed by the low nibble lo of a byte: bit h of low_rows[lo] says whether
+		// h * 16 + lo is in the set for h < 8, and high_rows does the same for h >= 8
+		alignas(16) std::array<std::uint8_t, 16> low_rows = {};
+		alignas(16) std::array<std::uint8_t, 16> high_rows = {};
+	};
+	auto prepare(const char_set& set) noexcept -> prepared_set;
+
+	// one implementation of every kernel; each level scans its own tail
+	struct kernel_table {
+		isa level;
+		// Copy the bytes of src[0, n) that are in `set` to dst, in order. dst has room for dst_size bytes,
+		// which must be at least the number of kept bytes. Returns the number of bytes written.
+		std::size_t (*compact)(const prepared_set& set, const char* src, std::size_t n, char* dst,
+		                       std::size_t dst_size) noexcept;
+		// number of bytes of src[0, n) that are in `set`
+		std::size_t (*count)(const prepared_set& set, const char* src, std::size_t n) noexcept;
+		// offset of the first byte of src[0, n) that is in `set`, or n if there is none
+		std::size_t (*find_first)(const prepared_set& set, const char* src, std::size_t n) noexcept;
+	};
+
+	// the kernels for `level`, or nullptr if this build or this CPU cannot run them
+	auto kernels_for(isa level) noexcept -> const kernel_table*;
+	// the kernels used by the functions below
+	auto active_kernels() noexcept -> const kernel_table&;
+
+	// Spans shorter than this are scanned by the scalar loop, which needs no tables and no dispatch.
+	inline constexpr std::size_t scalar_cutoff = 32;
+
+	// The kernels of active_kernels(). The char_set forms prepare the set on each call, unless the span
+	// is short enough for the scalar loop.
+	auto compact(const char_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept
+	   -> std::size_t;
+	auto compact(const prepared_set& set, const char* src, std::size_t n, char* dst, std::size_t dst_size) noexcept
+	   -> std::size_t;
+	auto count(const char_set& set, const char* src, std::size_t n) noexcept -> std::size_t;
+	auto count(const prepared_set& set, const char* src, std::size_t n) noexcept -> std::size_t;
+	auto find_first(const char_set& set, const char* src, std::size_t n) noexcept -> std::size_t;
+	auto find_first(const prepared_set& set, const char* src, std::size_t n) noexcept -> std::size_t;
+	// Compare the bytes of lhs[0, ln) in lset with the bytes of rhs[0, rn) in rset, like memcmp on the
+	// two filtered strings followed by their lengths. Both sides are compacted a block at a time into
+	// buffers on the stack, so it stops soon after the first difference.
+	auto compare(const char_set& lset, const char* lhs, std::size_t ln, const char_set& rset, const char* rhs,
+	             std::size_t rn) noexcept -> int;
+
+	// Offset of the first byte of src[0, n) in `set`, or n. The first few bytes are tested inline and
+	// only a longer gap goes to the kernel, so stepping to a nearby byte costs no more than a lookup.
+	inline auto find_first_near(const char_set& set, const char* src, std::size_t n) noexcept -> std::size_t {
+		const auto head = n < scalar_cutoff ? n : scalar_cutoff;
+		for (std::size_t i = 0; i < head; ++i) {
+			if (set.contains(src[i])) {
+				return i;
+			}
+		}
+		return head == n ? n : head + find_first(set, src + head, n - head);
+	}
+} // namespace fsv::detail
+
+#endif // COMP6771_ASS2_KERNELS_H
@@ -0,0 +1,98 @@
+#include "./kernels.h"
+#include <catch2/catch.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+	// a set holding each char value with probability p
+	auto random_set(std::mt19937& rng, double p) -> fsv::char_set {
+		auto set = fsv::char_set{};
+		auto coin = std::bernoulli_distribution{p};
+		for (int c = 0; c < 256; ++c) {
+			if (coin(rng)) {
+				set.insert(static_cast<char>(c));
+			}
+		}
+		return set;
+	}
+
+	// random bytes, with most of them drawn from a few values so that runs of kept bytes occur
+	auto random_bytes(std::mt19937& rng, std::size_t n) -> std::string {
+		auto bytes = std::string(n, '\0');
+		auto byte = std::uniform_int_distribution<int>{0, 255};
+		auto common = std::uniform_int_distribution<int>{0, 3};
+		for (auto& c : bytes) {
+			c = static_cast<char>(common(rng) == 0 ? byte(rng) : "a \n\xe9"[common(rng)]);
+		}
+		return bytes;
+	}
+} // namespace
+
+TEST_CASE("Test isa names round trip") {
+	for (auto level : fsv::detail::all_isas) {
+		REQUIRE(fsv::detail::isa_from_name(fsv::detail::isa_name(level)) == level);
+	}
+	REQUIRE_FALSE(fsv::detail::isa_from_name("mmx").has_value());
+	REQUIRE(fsv::detail::kernels_for(fsv::detail::isa::scalar) != nullptr);
+	REQUIRE(fsv::detail::kernels_for(fsv::detail::active_kernels().level) == &fsv::detail::active_kernels());
+}
+
+TEST_CASE("Test every kernel level against the scalar reference") {
+	const auto& reference = *fsv::detail::kernels_for(fsv::detail::isa::scalar);
+	auto rng = std::mt19937{6771};
+	auto length = std::uniform_int_distribution<std::size_t>{0, 700};
+	auto offset = std::uniform_int_distribution<std::size_t>{0, 63};
+	const auto buffer = random_bytes(rng, 1 << 12);
+
+	for (auto level : fsv::detail::all_isas) {
+		const auto* kernels = fsv::detail::kernels_for(level);
+		if (kernels == nullptr) {
+			WARN("skipping " << fsv::detail::isa_name(level) << ": not supported here");
+			continue;
+		}
+		INFO("isa " << fsv::detail::isa_name(level));
+		for (double p : {0.0, 0.01, 0.1, 0.5, 0.9, 0.99, 1.0}) {
+			INFO("selectivity " << p);
+			for (int trial = 0; trial < 50; ++trial) {
+				const auto set =
+				   fsv::detail::prepare(random_set(rng, p) | (p > 0.5 ? fsv::char_set::of("a \n\xe9") : fsv::char_set{}));
+				const auto n = length(rng);
+				const char* src = buffer.data() + offset(rng);
+
+				const auto expected_count = reference.count(set, src, n);
+				REQUIRE(kernels->count(set, src, n) == expected_count);
+				REQUIRE(kernels->find_first(set, src, n) == reference.find_first(set, src, n));
+
+				// exact-size output followed by guard bytes that must survive
+				auto expected = std::string(expected_count, '\0');
+				reference.compact(set, src, n, expected.data(), expected.size());
+				auto out = std::vector<char>(expected_count + 64, '#');
+				REQUIRE(kernels->compact(set, src, n, out.data(), expected_count) == expected_count);
+				REQUIRE(std::string(out.data(), expected_count) == expected);
+				REQUIRE(std::string(out.data() + expected_count, 64) == std::string(64, '#'));
+			}
+		}
+	}
+}
+
+TEST_CASE("Test the dispatched kernels on spans around the scalar cutoff") {
+	const auto& reference = *fsv::detail::kernels_for(fsv::detail::isa::scalar);
+	auto rng = std::mt19937{2024};
+	const auto buffer = random_bytes(rng, 256);
+	const auto set = random_set(rng, 0.3);
+	const auto prepared = fsv::detail::prepare(set);
+	REQUIRE(prepared.set == set);
+	for (std::size_t n = 0; n <= 3 * fsv::detail::scalar_cutoff; ++n) {
+		INFO("n " << n);
+		const auto expected = reference.count(prepared, buffer.data(), n);
+		REQUIRE(fsv::detail::count(set, buffer.data(), n) == expected);
+		REQUIRE(fsv::detail::count(prepared, buffer.data(), n) == expected);
+		const auto first = reference.find_first(prepared, buffer.data(), n);
+		REQUIRE(fsv::detail::find_first(set, buffer.data(), n) == first);
+		REQUIRE(fsv::detail::find_first(prepared, buffer.data(), n) == first);
+		REQUIRE(fsv::detail::find_first_near(set, buffer.data(), n) == first);
+		auto out = std::string(expected, '\0');
+		REQUIRE(fsv::detail::compact(set, buffer.data(), n, out.data(), out.size()) == expected);
+	}
+}
@@ -0,0 +1,226 @@
+#ifndef COMP6771_ASS2_LITERAL_VIEW_H
+#define COMP6771_ASS2_LITERAL_VIEW_H
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+#include "./char_set.h"
+
+// Compile-time filtering of literals. basic_filtered_string_view caches an index and may erase its
+// predicate, so it cannot be constexpr; literal_view is the constexpr counterpart for string literals
+// and literal predicates (char_set or a capture-less lambda), and fixed_string holds its result.
+namespace fsv {
+	// Up to N chars stored inline and null-terminated, usable in constant expressions.
+	template<std::size_t N>
+	class fixed_string {
+	 public:
+		// constructor: the empty string
+		constexpr fixed_string() noexcept = default;
+
+		constexpr auto size() const noexcept -> std::size_t {
+			return size_;
+		}
+		static constexpr auto capacity() noexcept -> std::size_t {
+			return N;
+		}
+		constexpr auto empty() const noexcept -> bool {
+			return size_ == 0;
+		}
+		constexpr auto data() const noexcept -> const char* {
+			return chars_.data();
+		}
+		constexpr auto operator[](std::size_t n) const noexcept -> char {
+			return chars_[n];
+		}
+		constexpr auto begin() const noexcept -> const char* {
+			return chars_.data();
+		}
+		constexpr auto end() const noexcept -> const char* {
+			return chars_.data() + size_;
+		}
+		constexpr auto view() const noexcept -> std::string_view {
+			return {chars_.data(), size_};
+		}
+		constexpr operator std::string_view() const noexcept {
+			return view();
+		}
+
+		// append c; throws std::length_error when full
+		constexpr auto push_back(char c) -> void {
+			if (size_ == N) {
+				throw std::length_error{"fixed_string::push_back: capacity exceeded"};
+			}
+			chars_[size_++] = c;
+		}
+
+		// compare fixed_string
+		friend constexpr auto operator==(const fixed_string& lhs, std::string_view rhs) noexcept -> bool {
+			return lhs.view() == rhs;
+		}
+		friend constexpr auto operator<=>(const fixed_string& lhs, std::string_view rhs) noexcept
+		   -> std::strong_ordering {
+			return lhs.view().compare(rhs) <=> 0;
+		}
+
+	 private:
+		std::array<char, N + 1> chars_ = {};
+		std::size_t size_ = 0;
+	};
+
+	// A constexpr filtered view of a literal. Every member scans the source, which is fine for the
+	// short strings it is meant for.
+	template<typename Pred = char_set>
+	class literal_view {
+		class iter {
+			friend class literal_view;
+
+		 public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = char;
+			using difference_type = std::ptrdiff_t;
+			// constructor
+			constexpr iter() noexcept = default;
+			constexpr auto operator*() const noexcept -> char {
+				return *pc_;
+			}
+			constexpr auto operator++() -> iter& {
+				pc_ = view_->next_kept(pc_ + 1);
+				return *this;
+			}
+			constexpr auto operator++(int) -> iter {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+			friend constexpr auto operator==(const iter& lhs, const iter& rhs) noexcept -> bool {
+				return lhs.pc_ == rhs.pc_;
+			}
+
+		 private:
+			constexpr iter(const char* pc, const literal_view& view) noexcept
+			: pc_(pc)
+			, view_(&view) {}
+
+			const char* pc_ = nullptr;
+			const literal_view* view_ = nullptr;
+		};
+
+	 public:
+		using predicate_type = Pred;
+		using iterator = iter;
+		using const_iterator = iter;
+
+		// constructor
+		constexpr literal_view(std::string_view s) noexcept
+		requires requires { Pred::all(); }
+		: source_(s)
+		, pred_(Pred::all()) {}
+		constexpr literal_view(std::string_view s, Pred predicate) noexcept
+		: source_(s)
+		, pred_(predicate) {}
+
+		// begin end
+		constexpr auto begin() const -> iterator {
+			return {next_kept(source_.data()), *this};
+		}
+		constexpr auto end() const noexcept -> iterator {
+			return {source_.data() + source_.size(), *this};
+		}
+
+		constexpr auto data() const noexcept -> const char* {
+			return source_.data();
+		}
+		constexpr auto source_size() const noexcept -> std::size_t {
+			return source_.size();
+		}
+		constexpr auto predicate() const noexcept -> const Pred& {
+			return pred_;
+		}
+		// get size after filtered
+		constexpr auto size() const -> std::size_t {
+			std::size_t n = 0;
+			for (char c : source_) {
+				n += static_cast<std::size_t>(pred_(c));
+			}
+			return n;
+		}
+		constexpr auto empty() const -> bool {
+			return begin() == end();
+		}
+		// get a character after filtered; throws std::domain_error, which fails a constant expression
+		constexpr auto at(std::size_t index) const -> char {
+			for (char c : *this) {
+				if (index-- == 0) {
+					return c;
+				}
+			}
+			throw std::domain_error{"literal_view::at: invalid index"};
+		}
+		constexpr auto operator[](std::size_t index) const -> char {
+			return at(index);
+		}
+
+		// the filtered characters; throws std::length_error if there are more than N
+		template<std::size_t N>
+		constexpr auto to_fixed() const -> fixed_string<N> {
+			auto str = fixed_string<N>{};
+			for (char c : *this) {
+				str.push_back(c);
+			}
+			return str;
+		}
+
+		// compare the filtered characters as unsigned char, like basic_filtered_string_view
+		friend constexpr auto operator==(const literal_view& lhs, std::string_view rhs) -> bool {
+			return std::is_eq(compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()));
+		}
+		friend constexpr auto operator<=>(const literal_view& lhs, std::string_view rhs) -> std::strong_ordering {
+			return compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+		}
+		friend constexpr auto operator==(const literal_view& lhs, const literal_view& rhs) -> bool {
+			return std::is_eq(compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()));
+		}
+		friend constexpr auto operator<=>(const literal_view& lhs, const literal_view& rhs) -> std::strong_ordering {
+			return compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+		}
+
+	 private:
+		template<typename It1, typename It2>
+		static constexpr auto compare(It1 l, It1 lend, It2 r, It2 rend) -> std::strong_ordering {
+			for (; l != lend && r != rend; ++l, ++r) {
+				if (*l != *r) {
+					return static_cast<unsigned char>(*l) <=> static_cast<unsigned char>(*r);
+				}
+			}
+			return (r == rend) <=> (l == lend);
+		}
+		// the first kept character at or after pc, or the end of the source
+		constexpr auto next_kept(const char* pc) const -> const char* {
+			const char* last = source_.data() + source_.size();
+			while (pc != last && !pred_(*pc)) {
+				pc++;
+			}
+			return pc;
+		}
+
+		std::string_view source_;
+		Pred pred_;
+	};
+
+	template<typename Pred>
+	literal_view(std::string_view, Pred) -> literal_view<Pred>;
+
+	// Filter a string literal in a constant expression, e.g.
+	//   constexpr auto kw = fsv::filter_literal("else-if", fsv::char_set::alpha());
+	//   static_assert(kw == "elseif");
+	template<std::size_t N, typename Pred>
+	constexpr auto filter_literal(const char (&s)[N], Pred predicate) -> fixed_string<N - 1> {
+		return literal_view{std::string_view{s, N - 1}, predicate}.template to_fixed<N - 1>();
+	}
+} // namespace fsv
+
+#endif // COMP6771_ASS2_LITERAL_VIEW_H
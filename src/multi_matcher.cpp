@@ -0,0 +1,87 @@
+#include "./multi_matcher.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace fsv {
+	FSV_INLINE multi_matcher::multi_matcher(std::initializer_list<std::string_view> patterns) {
+		build(std::vector<std::string_view>(patterns));
+	}
+
+	FSV_INLINE std::size_t multi_matcher::pattern_count() const noexcept {
+		return lengths_.size();
+	}
+	FSV_INLINE std::size_t multi_matcher::state_count() const noexcept {
+		return output_begin_.size() - 1;
+	}
+	FSV_INLINE std::size_t multi_matcher::memory_usage() const noexcept {
+		return sizeof(column_) + lengths_.size() * sizeof(std::size_t) + next_.size() * sizeof(state_type)
+		       + (output_begin_.size() + outputs_.size()) * sizeof(std::uint32_t);
+	}
+
+	FSV_INLINE void multi_matcher::build(const std::vector<std::string_view>& patterns) {
+		// column 0 is shared by the bytes that appear in no pattern
+		columns_ = 1;
+		for (auto pattern : patterns) {
+			if (pattern.empty()) {
+				throw std::invalid_argument{"multi_matcher: empty pattern"};
+			}
+			for (char c : pattern) {
+				auto& column = column_[static_cast<unsigned char>(c)];
+				if (column == 0) {
+					column = static_cast<std::uint16_t>(columns_++);
+				}
+			}
+			lengths_.push_back(pattern.size());
+			longest_ = std::max(longest_, pattern.size());
+		}
+
+		// the trie; an edge to 0 means none yet, as the root is nobody's child
+		auto ends = std::vector<std::vector<std::uint32_t>>(1);
+		next_.assign(columns_, 0);
+		for (std::size_t p = 0; p < patterns.size(); p++) {
+			state_type s = 0;
+			for (char c : patterns[p]) {
+				const auto edge = s * columns_ + column_[static_cast<unsigned char>(c)];
+				if (next_[edge] == 0) {
+					next_[edge] = static_cast<state_type>(ends.size());
+					ends.emplace_back();
+					next_.resize(next_.size() + columns_, 0);
+				}
+				s = next_[edge];
+			}
+			ends[s].push_back(static_cast<std::uint32_t>(p));
+		}
+
+		// Breadth first, so a state's failure state is finished before it: trie edges get their failure
+		// state, missing edges become the failure state's edge, and each state reports the patterns of
+		// its failure state too. A row still holds only trie edges when its state is reached.
+		auto fail = std::vector<state_type>(ends.size(), 0);
+		auto order = std::vector<state_type>{0};
+		order.reserve(ends.size());
+		for (std::size_t i = 0; i < order.size(); i++) {
+			const auto s = order[i];
+			if (s != 0) {
+				const auto& inherited = ends[fail[s]];
+				ends[s].insert(ends[s].end(), inherited.begin(), inherited.end());
+			}
+			for (std::size_t c = 0; c < columns_; c++) {
+				const auto child = next_[s * columns_ + c];
+				const auto fallback = s == 0 ? 0 : next_[fail[s] * columns_ + c];
+				if (child != 0) {
+					fail[child] = fallback;
+					order.push_back(child);
+				}
+				else {
+					next_[s * columns_ + c] = fallback;
+				}
+			}
+		}
+
+		output_begin_.reserve(ends.size() + 1);
+		output_begin_.push_back(0);
+		for (const auto& patterns_here : ends) {
+			outputs_.insert(outputs_.end(), patterns_here.begin(), patterns_here.end());
+			output_begin_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+		}
+	}
+} // namespace fsv
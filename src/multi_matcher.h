@@ -0,0 +1,135 @@
+#ifndef COMP6771_ASS2_MULTI_MATCHER_H
+#define COMP6771_ASS2_MULTI_MATCHER_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "./build_mode.h"
+#include "./filtered_string_view.h"
+
+namespace fsv {
+	// one occurrence of a pattern in a view
+	struct match {
+		// index of the pattern in the list the matcher was built from
+		std::size_t pattern;
+		// filtered index of its first character
+		std::size_t offset;
+		// source offset of its first character
+		std::size_t source_offset;
+
+		friend auto operator==(const match& lhs, const match& rhs) noexcept -> bool = default;
+	};
+
+	// Aho-Corasick automaton for a fixed set of patterns, built once and reused for many views. Bytes
+	// that appear in no pattern share one column of the transition table, and the table is a single
+	// array of states * columns entries with every failure transition resolved in advance, so the scan
+	// does one lookup per kept character. Views are read run by run, never materialised.
+	class multi_matcher {
+	 public:
+		// any range of things convertible to std::string_view; throws std::invalid_argument for an
+		// empty pattern
+		template<typename Range>
+		explicit multi_matcher(const Range& patterns);
+		multi_matcher(std::initializer_list<std::string_view> patterns);
+
+		auto pattern_count() const noexcept -> std::size_t;
+		// number of automaton states, and bytes held by the tables
+		auto state_count() const noexcept -> std::size_t;
+		auto memory_usage() const noexcept -> std::size_t;
+
+		// call on_match(const match&) for every occurrence, in order of where they end; a bool result of
+		// false stops the scan
+		template<typename Pred, typename F>
+		auto for_each_match(const basic_filtered_string_view<Pred>& view, F&& on_match) const -> void;
+		// every occurrence, in order of where they end
+		template<typename Pred>
+		auto find_all(const basic_filtered_string_view<Pred>& view) const -> std::vector<match>;
+		// whether any pattern occurs, stopping at the first one
+		template<typename Pred>
+		auto matches_any(const basic_filtered_string_view<Pred>& view) const -> bool;
+
+	 private:
+		using state_type = std::uint32_t;
+
+		auto build(const std::vector<std::string_view>& patterns) -> void;
+
+		// length of each pattern, and of the longest
+		std::vector<std::size_t> lengths_;
+		std::size_t longest_ = 0;
+		// column of each byte value
+		std::array<std::uint16_t, 256> column_ = {};
+		std::size_t columns_ = 0;
+		// next state for state s and column c at s * columns_ + c; state 0 is the root
+		std::vector<state_type> next_;
+		// patterns ending at state s are outputs_[output_begin_[s], output_begin_[s + 1])
+		std::vector<std::uint32_t> output_begin_;
+		std::vector<std::uint32_t> outputs_;
+	};
+
+	template<typename Range>
+	multi_matcher::multi_matcher(const Range& patterns) {
+		auto views = std::vector<std::string_view>{};
+		for (const auto& pattern : patterns) {
+			views.emplace_back(pattern);
+		}
+		build(views);
+	}
+
+	template<typename Pred, typename F>
+	auto multi_matcher::for_each_match(const basic_filtered_string_view<Pred>& view, F&& on_match) const -> void {
+		if (lengths_.empty()) {
+			return;
+		}
+		// source offsets of the last `longest_` kept characters, to find where a match began
+		const auto mask = std::bit_ceil(longest_) - 1;
+		auto recent = std::vector<std::size_t>(mask + 1);
+		state_type state = 0;
+		std::size_t filtered = 0;
+		for (auto run : view.runs()) {
+			const auto base = static_cast<std::size_t>(run.data() - view.data());
+			for (std::size_t i = 0; i < run.size(); i++, filtered++) {
+				recent[filtered & mask] = base + i;
+				state = next_[state * columns_ + column_[static_cast<unsigned char>(run[i])]];
+				for (auto k = output_begin_[state]; k < output_begin_[state + 1]; k++) {
+					const auto first = filtered + 1 - lengths_[outputs_[k]];
+					const auto found = match{outputs_[k], first, recent[first & mask]};
+					if constexpr (std::is_same_v<std::invoke_result_t<F&, const match&>, bool>) {
+						if (!on_match(found)) {
+							return;
+						}
+					}
+					else {
+						on_match(found);
+					}
+				}
+			}
+		}
+	}
+	template<typename Pred>
+	auto multi_matcher::find_all(const basic_filtered_string_view<Pred>& view) const -> std::vector<match> {
+		auto matches = std::vector<match>{};
+		for_each_match(view, [&matches](const match& m) { matches.push_back(m); });
+		return matches;
+	}
+	template<typename Pred>
+	auto multi_matcher::matches_any(const basic_filtered_string_view<Pred>& view) const -> bool {
+		bool found = false;
+		for_each_match(view, [&found](const match&) {
+			found = true;
+			return false;
+		});
+		return found;
+	}
+} // namespace fsv
+
+#ifdef FSV_HEADER_ONLY
+#include "./multi_matcher.cpp"
+#endif
+
+#endif // COMP6771_ASS2_MULTI_MATCHER_H
@@ -0,0 +1,93 @@
+#include "./multi_matcher.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+	// every occurrence of every pattern in the filtered string, in the order a multi_matcher reports them
+	template<typename Pred>
+	auto naive_find_all(const fsv::basic_filtered_string_view<Pred>& view, const std::vector<std::string>& patterns)
+	   -> std::vector<fsv::match> {
+		auto filtered = std::string{};
+		auto source = std::vector<std::size_t>{};
+		for (auto it = view.begin(); it != view.end(); ++it) {
+			filtered.push_back(*it);
+			source.push_back(static_cast<std::size_t>(&*it - view.data()));
+		}
+		auto matches = std::vector<fsv::match>{};
+		for (std::size_t end = 1; end <= filtered.size(); end++) {
+			// longer patterns ending here first, like the automaton's output lists
+			auto here = std::vector<fsv::match>{};
+			for (std::size_t p = 0; p < patterns.size(); p++) {
+				const auto n = patterns[p].size();
+				if (n <= end && filtered.compare(end - n, n, patterns[p]) == 0) {
+					here.push_back({p, end - n, source[end - n]});
+				}
+			}
+			std::stable_sort(here.begin(), here.end(), [](const fsv::match& a, const fsv::match& b) {
+				return a.offset < b.offset;
+			});
+			matches.insert(matches.end(), here.begin(), here.end());
+		}
+		return matches;
+	}
+
+	auto random_string(std::mt19937& rng, std::size_t n, std::string_view alphabet) -> std::string {
+		auto pick = std::uniform_int_distribution<std::size_t>{0, alphabet.size() - 1};
+		auto s = std::string(n, '\0');
+		for (auto& c : s) {
+			c = alphabet[pick(rng)];
+		}
+		return s;
+	}
+} // namespace
+
+TEST_CASE("Test multi_matcher finds overlapping patterns") {
+	const auto matcher = fsv::multi_matcher{"he", "she", "his", "hers"};
+	CHECK(matcher.pattern_count() == 4);
+	CHECK(matcher.state_count() == 10);
+	CHECK(matcher.memory_usage() > 0);
+
+	const auto view = fsv::filtered_string_view{"u-s-h-e-r-s", [](const char& c) { return c != '-'; }};
+	const auto expected = std::vector<fsv::match>{{1, 1, 2}, {0, 2, 4}, {3, 2, 4}};
+	CHECK(matcher.find_all(view) == expected);
+	CHECK(matcher.matches_any(view));
+	CHECK_FALSE(matcher.matches_any(fsv::filtered_string_view{"h-i-e"}));
+}
+
+TEST_CASE("Test multi_matcher stops when the callback returns false") {
+	const auto matcher = fsv::multi_matcher{"a"};
+	const auto view = fsv::filtered_string_view{"aaaa"};
+	std::size_t calls = 0;
+	matcher.for_each_match(view, [&calls](const fsv::match&) { return ++calls < 2; });
+	CHECK(calls == 2);
+}
+
+TEST_CASE("Test multi_matcher with no patterns or an empty pattern") {
+	const auto none = fsv::multi_matcher{std::vector<std::string>{}};
+	CHECK(none.pattern_count() == 0);
+	CHECK(none.find_all(fsv::filtered_string_view{"abc"}).empty());
+	CHECK_THROWS_AS((fsv::multi_matcher{"a", ""}), std::invalid_argument);
+}
+
+TEST_CASE("Test multi_matcher against a naive search") {
+	auto rng = std::mt19937{6771};
+	for (int round = 0; round < 200; round++) {
+		auto patterns = std::vector<std::string>{};
+		const auto count = std::uniform_int_distribution<int>{1, 8}(rng);
+		for (int p = 0; p < count; p++) {
+			patterns.push_back(random_string(rng, std::uniform_int_distribution<std::size_t>{1, 5}(rng), "abc"));
+		}
+		const auto matcher = fsv::multi_matcher{patterns};
+		const auto source = random_string(rng, 300, "abc-_");
+
+		const auto table = fsv::basic_filtered_string_view<fsv::char_set>{source, fsv::char_set::of("abc")};
+		CHECK(matcher.find_all(table) == naive_find_all(table, patterns));
+		const auto opaque = fsv::filtered_string_view{source, [](const char& c) { return c != '-'; }};
+		CHECK(matcher.find_all(opaque) == naive_find_all(opaque, patterns));
+		CHECK(matcher.matches_any(opaque) == !naive_find_all(opaque, patterns).empty());
+	}
+}
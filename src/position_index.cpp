@@ -0,0 +1,148 @@
+#include "./position_index.h"
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace fsv::detail {
+	// class offset_index
+	FSV_INLINE offset_index::offset_index(std::vector<std::size_t> offsets, std::size_t source_size) noexcept
+	: offsets_(std::move(offsets))
+	, source_size_(source_size) {}
+
+	FSV_INLINE std::size_t offset_index::size() const noexcept {
+		return offsets_.size();
+	}
+	FSV_INLINE bool offset_index::exact() const noexcept {
+		return true;
+	}
+	FSV_INLINE index_position offset_index::seek(std::size_t n) const noexcept {
+		if (n >= offsets_.size()) {
+			return {source_size_, offsets_.size()};
+		}
+		return {offsets_[n], n};
+	}
+	FSV_INLINE index_position offset_index::seek_offset(std::size_t offset) const noexcept {
+		const auto it = std::lower_bound(offsets_.begin(), offsets_.end(), offset);
+		return {offset, static_cast<std::size_t>(it - offsets_.begin())};
+	}
+	FSV_INLINE std::size_t offset_index::memory_usage() const noexcept {
+		return offsets_.capacity() * sizeof(std::size_t);
+	}
+
+	// class rank_select_index
+	FSV_INLINE rank_select_index::rank_select_index(std::vector<word_type> bits, std::size_t source_size)
+	: bits_(std::move(bits))
+	, source_size_(source_size) {
+		const auto blocks = (bits_.size() + words_per_block - 1) / words_per_block;
+		block_ranks_.reserve(blocks + 1);
+		superblock_ranks_.reserve(blocks / blocks_per_superblock + 1);
+		for (std::size_t b = 0; b <= blocks; ++b) {
+			if (b % blocks_per_superblock == 0) {
+				superblock_ranks_.push_back(ones_);
+			}
+			block_ranks_.push_back(static_cast<std::uint16_t>(ones_ - superblock_ranks_.back()));
+			for (auto w = b * words_per_block; w < std::min((b + 1) * words_per_block, bits_.size()); ++w) {
+				const auto count = static_cast<std::size_t>(std::popcount(bits_[w]));
+				// remember the block holding every select_sample_rate-th kept character
+				if ((ones_ + select_sample_rate - 1) / select_sample_rate
+				    != (ones_ + count + select_sample_rate - 1) / select_sample_rate)
+				{
+					select_samples_.push_back(b);
+				}
+				ones_ += count;
+			}
+		}
+	}
+
+	FSV_INLINE std::size_t rank_select_index::size() const noexcept {
+		return ones_;
+	}
+	FSV_INLINE bool rank_select_index::exact() const noexcept {
+		return true;
+	}
+	FSV_INLINE index_position rank_select_index::seek(std::size_t n) const noexcept {
+		if (n >= ones_) {
+			return {source_size_, ones_};
+		}
+		return {select(n), n};
+	}
+	FSV_INLINE index_position rank_select_index::seek_offset(std::size_t offset) const noexcept {
+		return {offset, rank(offset)};
+	}
+	FSV_INLINE std::size_t rank_select_index::memory_usage() const noexcept {
+		return bits_.capacity() * sizeof(word_type) + superblock_ranks_.capacity() * sizeof(std::uint64_t)
+		       + block_ranks_.capacity() * sizeof(std::uint16_t) + select_samples_.capacity() * sizeof(std::size_t);
+	}
+
+	FSV_INLINE std::size_t rank_select_index::block_rank(std::size_t b) const noexcept {
+		return static_cast<std::size_t>(superblock_ranks_[b / blocks_per_superblock]) + block_ranks_[b];
+	}
+	FSV_INLINE std::size_t rank_select_index::rank(std::size_t offset) const noexcept {
+		if (offset >= source_size_) {
+			return ones_;
+		}
+		const auto word = offset / 64;
+		auto result = block_rank(word / words_per_block);
+		for (auto w = word - word % words_per_block; w < word; ++w) {
+			result += static_cast<std::size_t>(std::popcount(bits_[w]));
+		}
+		const auto below = bits_[word] & ((word_type{1} << (offset % 64)) - 1);
+		return result + static_cast<std::size_t>(std::popcount(below));
+	}
+	FSV_INLINE std::size_t rank_select_index::select(std::size_t n) const noexcept {
+		// the last block whose rank is <= n, between two samples
+		const auto sample = n / select_sample_rate;
+		auto lo = select_samples_[sample];
+		auto hi = sample + 1 < select_samples_.size() ? select_samples_[sample + 1] : block_ranks_.size() - 1;
+		while (lo < hi) {
+			const auto mid = lo + (hi - lo + 1) / 2;
+			if (block_rank(mid) <= n) {
+				lo = mid;
+			}
+			else {
+				hi = mid - 1;
+			}
+		}
+		// the word inside the block, then the bit inside the word
+		auto remaining = n - block_rank(lo);
+		auto w = lo * words_per_block;
+		for (auto count = static_cast<std::size_t>(std::popcount(bits_[w])); count <= remaining;
+		     count = static_cast<std::size_t>(std::popcount(bits_[w])))
+		{
+			remaining -= count;
+			++w;
+		}
+		auto word = bits_[w];
+		for (; remaining > 0; --remaining) {
+			word &= word - 1;
+		}
+		return w * 64 + static_cast<std::size_t>(std::countr_zero(word));
+	}
+
+	// class checkpoint_index
+	FSV_INLINE checkpoint_index::checkpoint_index(std::vector<std::size_t> checkpoints, std::size_t interval) noexcept
+	: checkpoints_(std::move(checkpoints))
+	, interval_(interval) {}
+
+	FSV_INLINE std::size_t checkpoint_index::size() const noexcept {
+		return checkpoints_.back();
+	}
+	FSV_INLINE bool checkpoint_index::exact() const noexcept {
+		return false;
+	}
+	FSV_INLINE index_position checkpoint_index::seek(std::size_t n) const noexcept {
+		// the last checkpoint with at most n kept characters before it; the final entry is the
+		// total rather than a checkpoint, so it is never chosen
+		const auto last = checkpoints_.end() - 1;
+		const auto it = std::upper_bound(checkpoints_.begin(), last, n) - 1;
+		const auto j = static_cast<std::size_t>(it - checkpoints_.begin());
+		return {j * interval_, *it};
+	}
+	FSV_INLINE index_position checkpoint_index::seek_offset(std::size_t offset) const noexcept {
+		const auto j = std::min(offset / interval_, checkpoints_.size() - 2);
+		return {j * interval_, checkpoints_[j]};
+	}
+	FSV_INLINE std::size_t checkpoint_index::memory_usage() const noexcept {
+		return checkpoints_.capacity() * sizeof(std::size_t);
+	}
+} // namespace fsv::detail
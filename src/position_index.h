@@ -0,0 +1,130 @@
+#ifndef COMP6771_ASS2_POSITION_INDEX_H
+#define COMP6771_ASS2_POSITION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "./build_mode.h"
+
+namespace fsv {
+	// how a view answers random access (at, operator[], iterator arithmetic); every index is built on
+	// first random access
+	enum class index_mode {
+		// offsets for small buffers, rank_select for large ones
+		automatic,
+		// scan from the start of the buffer on every access
+		none,
+		// source offset of every kept character: 8 bytes per kept character
+		offsets,
+		// one bit per source byte plus rank and select samples: about n / 8 + n / 200 bytes
+		rank_select,
+		// kept count every K source bytes: 8 * (n / K + 2) bytes, lookups binary search then scan < K bytes
+		sparse,
+	};
+
+	namespace detail {
+		// largest source size index_mode::automatic builds an offset_index for
+		inline constexpr std::size_t automatic_offsets_limit = 4096;
+		// default K for index_mode::sparse
+		inline constexpr std::size_t default_checkpoint_interval = 4096;
+
+		// a point in the source buffer: `rank` kept characters lie before source offset `offset`
+		struct index_position {
+			std::size_t offset;
+			std::size_t rank;
+		};
+
+		// Maps between filtered indices and source offsets of one view. Lookups return a position at
+		// or before the one asked for; the view scans forward from there with its predicate, which
+		// lets coarse indexes trade memory for a short scan.
+		class position_index {
+		 public:
+			virtual ~position_index() = default;
+			// number of kept characters
+			virtual auto size() const noexcept -> std::size_t = 0;
+			// true if seek(n) lands exactly on the n-th kept character, so no scan is needed
+			virtual auto exact() const noexcept -> bool = 0;
+			// a position at or before the n-th kept character
+			virtual auto seek(std::size_t n) const noexcept -> index_position = 0;
+			// a position at or before source offset `offset`
+			virtual auto seek_offset(std::size_t offset) const noexcept -> index_position = 0;
+			// bytes allocated by the index
+			virtual auto memory_usage() const noexcept -> std::size_t = 0;
+		};
+
+		// exact index: the source offset of each kept character
+		class offset_index final : public position_index {
+		 public:
+			offset_index(std::vector<std::size_t> offsets, std::size_t source_size) noexcept;
+			auto size() const noexcept -> std::size_t override;
+			auto exact() const noexcept -> bool override;
+			auto seek(std::size_t n) const noexcept -> index_position override;
+			auto seek_offset(std::size_t offset) const noexcept -> index_position override;
+			auto memory_usage() const noexcept -> std::size_t override;
+
+		 private:
+			std::vector<std::size_t> offsets_;
+			std::size_t source_size_;
+		};
+
+		// Succinct index over a bitvector of kept source bytes. rank() reads one superblock count, one
+		// block count and at most 7 words; select() starts from a sample taken every 4096 kept
+		// characters, binary searches the block counts up to the next sample and then looks at
+		// one block.
+		class rank_select_index final : public position_index {
+		 public:
+			using word_type = std::uint64_t;
+			// bit i % 64 of bits[i / 64] is set when source byte i is kept
+			rank_select_index(std::vector<word_type> bits, std::size_t source_size);
+			auto size() const noexcept -> std::size_t override;
+			auto exact() const noexcept -> bool override;
+			auto seek(std::size_t n) const noexcept -> index_position override;
+			auto seek_offset(std::size_t offset) const noexcept -> index_position override;
+			auto memory_usage() const noexcept -> std::size_t override;
+
+			// number of kept characters before source offset `offset`
+			auto rank(std::size_t offset) const noexcept -> std::size_t;
+			// source offset of the n-th kept character, n < size()
+			auto select(std::size_t n) const noexcept -> std::size_t;
+
+		 private:
+			static constexpr std::size_t words_per_block = 8;
+			static constexpr std::size_t blocks_per_superblock = 128;
+			static constexpr std::size_t select_sample_rate = 4096;
+
+			// kept characters before block b
+			auto block_rank(std::size_t b) const noexcept -> std::size_t;
+
+			std::vector<word_type> bits_;
+			std::vector<std::uint64_t> superblock_ranks_;
+			std::vector<std::uint16_t> block_ranks_;
+			std::vector<std::size_t> select_samples_;
+			std::size_t source_size_;
+			std::size_t ones_ = 0;
+		};
+
+		// coarse index: the number of kept characters before every interval-th source byte
+		class checkpoint_index final : public position_index {
+		 public:
+			// checkpoints[j] counts the kept characters before source offset j * interval, and the
+			// last entry is the total
+			checkpoint_index(std::vector<std::size_t> checkpoints, std::size_t interval) noexcept;
+			auto size() const noexcept -> std::size_t override;
+			auto exact() const noexcept -> bool override;
+			auto seek(std::size_t n) const noexcept -> index_position override;
+			auto seek_offset(std::size_t offset) const noexcept -> index_position override;
+			auto memory_usage() const noexcept -> std::size_t override;
+
+		 private:
+			std::vector<std::size_t> checkpoints_;
+			std::size_t interval_;
+		};
+	} // namespace detail
+} // namespace fsv
+
+#ifdef FSV_HEADER_ONLY
+#include "./position_index.cpp"
+#endif
+
+#endif // COMP6771_ASS2_POSITION_INDEX_H
@@ -0,0 +1,70 @@
+#ifndef COMP6771_ASS2_SEARCH_H
+#define COMP6771_ASS2_SEARCH_H
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fsv::detail {
+	// Boyer-Moore-Horspool over a stream of characters that can only be read forward once, such as
+	// the kept characters of a view. The last needle.size() characters are kept in a ring; after a
+	// mismatch the window slides by the bad-character shift of its last character, so most windows
+	// are rejected after one comparison.
+	class horspool {
+	 public:
+		explicit horspool(std::string_view needle)
+		: needle_(needle) {
+			shift_.fill(needle_.size());
+			for (std::size_t k = 0; k + 1 < needle_.size(); k++) {
+				shift_[static_cast<unsigned char>(needle_[k])] = needle_.size() - 1 - k;
+			}
+		}
+
+		// Index in the stream of the first match, or nullopt. next() returns the next character, or
+		// nullopt at the end of the stream. The needle must not be empty.
+		template<typename Next>
+		auto search(Next next) const -> std::optional<std::size_t> {
+			const auto m = needle_.size();
+			auto window = std::string(m, '\0');
+			for (auto& c : window) {
+				const auto read = next();
+				if (!read) {
+					return std::nullopt;
+				}
+				c = *read;
+			}
+			// window[(head + k) % m] is the k-th character of the current window
+			std::size_t head = 0;
+			std::size_t start = 0;
+			while (true) {
+				const char last = window[(head + m - 1) % m];
+				if (last == needle_[m - 1]) {
+					auto k = m - 1;
+					while (k > 0 && window[(head + k - 1) % m] == needle_[k - 1]) {
+						k--;
+					}
+					if (k == 0) {
+						return start;
+					}
+				}
+				for (auto shift = shift_[static_cast<unsigned char>(last)]; shift > 0; shift--) {
+					const auto read = next();
+					if (!read) {
+						return std::nullopt;
+					}
+					window[head] = *read;
+					head = (head + 1) % m;
+					start++;
+				}
+			}
+		}
+
+	 private:
+		std::string needle_;
+		std::array<std::size_t, 256> shift_ = {};
+	};
+} // namespace fsv::detail
+
+#endif // COMP6771_ASS2_SEARCH_H